@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "image.h"
+#include "pack.h"
+
+//decodes pngs and writes them into one asset pack, scaled to the size they're drawn at
+//usage: assetpack pack file.png[:WxH]...
+//
+//without a size an image is packed as it is. the games look images up by the path they load
+//them from, so the files are named the same way here, e.g. for both games:
+//assetpack assets.pak whitepawn.png ... blackking.png spaceship.png:100x100 projectile.png:20x100 vqrus.png:100x100
+
+int main(int argc, char** argv){
+	if(argc < 3){
+		printf("usage: assetpack pack file.png[:WxH]...\n");
+		return -1;
+	}
+	uint32_t count = argc - 2;
+	packentry_t* entries = (packentry_t*)calloc(count, sizeof(packentry_t));
+	image_t* images = (image_t*)calloc(count, sizeof(image_t));
+	if(!entries || !images){
+		printf("Failed to allocate memory\n");
+		return -1;
+	}
+
+	uint64_t offset = sizeof(packheader_t) + (uint64_t)count * sizeof(packentry_t);
+	uint64_t packed = 0;
+	for(uint32_t i = 0; i < count; i++){
+		char name[256];
+		snprintf(name, sizeof(name), "%s", argv[i + 2]);
+		int width = 0;
+		int height = 0;
+		char* size = strrchr(name, ':');
+		if(size){
+			if(sscanf(size + 1, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0){
+				printf("Failed to parse size of %s\n", argv[i + 2]);
+				return -1;
+			}
+			*size = 0;
+		}
+		if(strlen(name) >= (size_t)PACK_NAME){
+			printf("Failed to pack %s, the name is too long\n", name);
+			return -1;
+		}
+		image_t image;
+		if(!image_load(&image, name)){
+			return -1;
+		}
+		if(size && (width != image.width || height != image.height)){
+			unsigned char* scaled = (unsigned char*)malloc((size_t)width * height * 4);
+			if(!scaled){
+				printf("Failed to allocate memory\n");
+				return -1;
+			}
+			image_resample(&image, scaled, width * 4, width, height);
+			image_free(&image);
+			image.pixels = scaled;
+			image.width = width;
+			image.height = height;
+		}
+		images[i] = image;
+
+		offset = (offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+		strcpy(entries[i].name, name);
+		entries[i].width = image.width;
+		entries[i].height = image.height;
+		entries[i].offset = offset;
+		offset += (uint64_t)image.width * image.height * 4;
+		packed += (uint64_t)image.width * image.height * 4;
+		printf("%s %dx%d\n", name, image.width, image.height);
+	}
+
+	FILE* file = fopen(argv[1], "wb");
+	if(!file){
+		printf("Failed to write %s\n", argv[1]);
+		return -1;
+	}
+	packheader_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+	header.count = count;
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(entries, sizeof(packentry_t), count, file);
+	const char zeros[PACK_ALIGN] = {0};
+	for(uint32_t i = 0; i < count; i++){
+		fwrite(zeros, 1, entries[i].offset - ftell(file), file);
+		fwrite(images[i].pixels, 4, (size_t)images[i].width * images[i].height, file);
+		image_free(&images[i]);
+	}
+	int ok = !ferror(file);
+	if(fclose(file) || !ok){
+		printf("Failed to write %s\n", argv[1]);
+		return -1;
+	}
+	printf("%u images %lu bytes of pixels\n", count, (unsigned long)packed);
+	free(entries);
+	free(images);
+	return 0;
+}
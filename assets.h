@@ -0,0 +1,217 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "image.h"
+#include "pack.h"
+#include "sprite.h"
+
+//images loaded in the background into an atlas, so a window is up and drawing while they arrive
+//
+//assets_load hands out a handle straight away. worker threads take the images in turn and get
+//their pixels, from the asset pack when it has them and else by decoding the png. GL can only be
+//used from the thread that owns the context, so assets_poll, called there once a frame, puts
+//whatever is decoded into the atlas. a handle is ASSET_LOADING until then and ASSET_READY or
+//ASSET_FAILED after, and the ready callback hears about each one as it settles
+//
+//loads are only ever added by the GL thread and each is written before the count that publishes
+//it, so workers and the GL thread share nothing but atomics. with nothing to load the workers
+//sleep on a condition variable until assets_load or assets_free wakes them
+
+const int ASSET_LOADING = 0;
+const int ASSET_READY = 1;
+const int ASSET_FAILED = 2;
+
+//what a worker left for assets_poll
+const int ASSET_PENDING = 0;
+const int ASSET_DECODED = 1;
+const int ASSET_UNREADABLE = 2;
+
+struct assetentry_s{
+	const char* filename;
+	//size it's stored in the atlas at
+	int width;
+	int height;
+	//pixels from the worker, pointing into the pack when packed
+	image_t image;
+	int packed;
+	std::atomic<int> decoded;
+	//only touched by the GL thread
+	int state;
+	sprite_t sprite;
+};
+
+typedef struct assetentry_s assetentry_t;
+
+struct assets_s{
+	atlas_t* atlas;
+	pack_t pack;
+	assetentry_t* entries;
+	int capacity;
+	//loads handed out, the next one a worker takes and how many haven't settled
+	std::atomic<int> count;
+	std::atomic<int> next;
+	int pending;
+	std::thread* workers;
+	int threads;
+	std::atomic<int> quit;
+	//idle workers wait on wake, only taken to sleep and to wake them
+	std::mutex lock;
+	std::condition_variable wake;
+	//called on the GL thread from assets_poll as each load settles, nullptr for none
+	void (*ready)(int handle, int state, void* user);
+	void* user;
+};
+
+typedef struct assets_s assets_t;
+
+inline void assets_worker(assets_t* assets){
+	while(!assets -> quit.load(std::memory_order_acquire)){
+		int handle = assets -> next.load(std::memory_order_relaxed);
+		if(handle >= assets -> count.load(std::memory_order_acquire)){
+			std::unique_lock<std::mutex> guard(assets -> lock);
+			assets -> wake.wait(guard, [assets]{
+				return assets -> quit.load(std::memory_order_acquire)
+				  || assets -> next.load(std::memory_order_relaxed) < assets -> count.load(std::memory_order_acquire);
+			});
+			continue;
+		}
+		if(!assets -> next.compare_exchange_weak(handle, handle + 1, std::memory_order_relaxed)){
+			continue;
+		}
+		assetentry_t* entry = &assets -> entries[handle];
+		entry -> packed = pack_image(&assets -> pack, entry -> filename, &entry -> image);
+		int ok = entry -> packed || image_load(&entry -> image, entry -> filename);
+		entry -> decoded.store(ok ? ASSET_DECODED : ASSET_UNREADABLE, std::memory_order_release);
+	}
+}
+
+//start threads workers for up to capacity loads into atlas, reading packfile when it exists.
+//returns 0 on failure
+inline int assets_create(assets_t* assets, atlas_t* atlas, const char* packfile, int capacity, int threads){
+	if(threads < 1){
+		threads = 1;
+	}
+	assets -> atlas = atlas;
+	assets -> capacity = capacity;
+	assets -> entries = new (std::nothrow) assetentry_t[capacity];
+	assets -> workers = new (std::nothrow) std::thread[threads];
+	if(!assets -> entries || !assets -> workers){
+		delete[] assets -> entries;
+		delete[] assets -> workers;
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	pack_open(&assets -> pack, packfile);
+	assets -> count = 0;
+	assets -> next = 0;
+	assets -> pending = 0;
+	assets -> quit = 0;
+	assets -> ready = nullptr;
+	assets -> user = nullptr;
+	assets -> threads = threads;
+	for(int t = 0; t < threads; t++){
+		assets -> workers[t] = std::thread(assets_worker, assets);
+	}
+	return 1;
+}
+
+//stop the workers and drop whatever never made it into the atlas
+inline void assets_free(assets_t* assets){
+	{
+		std::lock_guard<std::mutex> guard(assets -> lock);
+		assets -> quit.store(1, std::memory_order_release);
+	}
+	assets -> wake.notify_all();
+	for(int t = 0; t < assets -> threads; t++){
+		assets -> workers[t].join();
+	}
+	int count = assets -> count.load(std::memory_order_relaxed);
+	for(int i = 0; i < count; i++){
+		assetentry_t* entry = &assets -> entries[i];
+		if(entry -> state == ASSET_LOADING && entry -> decoded.load(std::memory_order_relaxed) == ASSET_DECODED && !entry -> packed){
+			image_free(&entry -> image);
+		}
+	}
+	pack_close(&assets -> pack);
+	delete[] assets -> workers;
+	delete[] assets -> entries;
+	assets -> workers = nullptr;
+	assets -> entries = nullptr;
+}
+
+//start loading filename to be stored at width by height, returns its handle or -1 if the manager
+//is full. filename has to outlive the load
+inline int assets_load(assets_t* assets, const char* filename, int width, int height){
+	int handle = assets -> count.load(std::memory_order_relaxed);
+	if(handle == assets -> capacity){
+		printf("Failed to load %s, too many assets\n", filename);
+		return -1;
+	}
+	assetentry_t* entry = &assets -> entries[handle];
+	entry -> filename = filename;
+	entry -> width = width;
+	entry -> height = height;
+	entry -> packed = 0;
+	entry -> decoded.store(ASSET_PENDING, std::memory_order_relaxed);
+	entry -> state = ASSET_LOADING;
+	assets -> pending++;
+	{
+		//under the lock, so a worker can't check for work and then miss the wakeup
+		std::lock_guard<std::mutex> guard(assets -> lock);
+		assets -> count.store(handle + 1, std::memory_order_release);
+	}
+	assets -> wake.notify_one();
+	return handle;
+}
+
+//on the GL thread: put decoded images into the atlas, returns how many loads are still out
+inline int assets_poll(assets_t* assets){
+	if(!assets -> pending){
+		return 0;
+	}
+	int count = assets -> count.load(std::memory_order_relaxed);
+	for(int handle = 0; handle < count; handle++){
+		assetentry_t* entry = &assets -> entries[handle];
+		if(entry -> state != ASSET_LOADING){
+			continue;
+		}
+		int decoded = entry -> decoded.load(std::memory_order_acquire);
+		if(decoded == ASSET_PENDING){
+			continue;
+		}
+		if(decoded == ASSET_DECODED){
+			entry -> state = atlas_add(assets -> atlas, &entry -> image, entry -> width, entry -> height, &entry -> sprite) ? ASSET_READY : ASSET_FAILED;
+			if(!entry -> packed){
+				image_free(&entry -> image);
+			}
+		} else{
+			entry -> state = ASSET_FAILED;
+		}
+		assets -> pending--;
+		if(assets -> ready){
+			assets -> ready(handle, entry -> state, assets -> user);
+		}
+	}
+	return assets -> pending;
+}
+
+inline int assets_state(const assets_t* assets, int handle){
+	return handle < 0 ? ASSET_FAILED : assets -> entries[handle].state;
+}
+
+//where a ready asset is in the atlas, nullptr while it's loading or if it failed
+inline const sprite_t* assets_sprite(const assets_t* assets, int handle){
+	if(assets_state(assets, handle) != ASSET_READY){
+		return nullptr;
+	}
+	return &assets -> entries[handle].sprite;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitboard.h"
+#include "tt.h"
+#include "search.h"
+#include "nanotime.h"
+
+//time to depth of the lazy smp search on 1, 2, 4, ... threads
+//usage: bench [depth] [maxthreads] [hash mb]    defaults 9, 16 and 64
+//every thread count starts from an empty table, so runs don't help each other
+
+//openings, middlegames and endgames, so no single kind of position decides the result
+const char* benchfens[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+};
+
+const int benchsize = sizeof(benchfens) / sizeof(benchfens[0]);
+
+int main(int argc, char** argv){
+	int depth = argc > 1 ? atoi(argv[1]) : 9;
+	int maxthreads = argc > 2 ? atoi(argv[2]) : 16;
+	int hash_mb = argc > 3 ? atoi(argv[3]) : 64;
+	if(depth < 1 || maxthreads < 1 || hash_mb < 1){
+		printf("usage: bench [depth] [maxthreads] [hash mb]\n");
+		return -1;
+	}
+	if(maxthreads > MAX_THREADS){
+		maxthreads = MAX_THREADS;
+	}
+
+	attacks_init();
+	tt_t hash;
+	if(!tt_create(&hash, hash_mb)){
+		return -1;
+	}
+	searcher_t* searchers = (searcher_t*)malloc(maxthreads * sizeof(searcher_t));
+	if(!searchers){
+		printf("Failed to allocate memory\n");
+		return -1;
+	}
+	searchshared_t shared;
+	searchshared_init(&shared, &hash);
+
+	searchlimits_t limits;
+	limits.depth = depth;
+	limits.movetime = 0;
+	limits.nodes = 0;
+	limits.infinite = 0;
+
+	double basetime = 0;
+	for(int threads = 1; threads <= maxthreads; threads *= 2){
+		unsigned long long nodes = 0;
+		double seconds = 0;
+		for(int i = 0; i < benchsize; i++){
+			position_t pos;
+			position_fromfen(&pos, benchfens[i]);
+			tt_clear(&hash);
+			tt_newsearch(&hash);
+			shared.stop = 0;
+			unsigned long start = nanotime();
+			search_parallel(searchers, threads, &pos, &shared, limits, nullptr);
+			seconds += (nanotime() - start) / 1e9;
+			nodes += search_nodes(searchers, threads);
+		}
+		if(seconds <= 0){
+			seconds = 1e-9;
+		}
+		if(threads == 1){
+			basetime = seconds;
+		}
+		printf("threads %2d depth %d nodes %llu time %.3fs nps %.0f speedup %.2f\n", threads, depth, nodes, seconds, nodes / seconds, basetime / seconds);
+	}
+
+	free(searchers);
+	tt_free(&hash);
+	return 0;
+}
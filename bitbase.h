@@ -0,0 +1,92 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bitboard.h"
+
+//win/draw bitbases for king and one piece against a bare king: KPK, KRK and KQK
+//
+//one bit per position, set when the side with the piece (the strong side) wins with best play.
+//the strong side can never lose these, so the bit and the side to move give the full result.
+//a position is indexed by whether the strong side moves, the two kings and the piece, all seen
+//with the strong side as white, so a table is 2^19 bits, 64KB
+//
+//the tables come from bitbasegen, which works them out backwards from mates over the same move
+//generator as everything else, and are loaded from one file at startup
+
+const int BITBASE_TABLES = 3;
+const int BITBASE_POSITIONS = 1 << 19;
+const int BITBASE_BYTES = BITBASE_POSITIONS / 8;
+
+//results of a probe, for the side to move
+const int BITBASE_LOSS = -1;
+const int BITBASE_DRAW = 0;
+const int BITBASE_WIN = 1;
+
+//file layout: the magic, then the KPK, KRK and KQK tables back to back
+const char BITBASE_MAGIC[8] = {'S', 'C', 'B', 'B', 'K', 'X', 'K', '1'};
+
+inline unsigned char bitbase_data[BITBASE_TABLES][BITBASE_BYTES];
+inline int bitbase_loaded = 0;
+
+//table holding the strong side's piece, -1 for pieces that can't win alone
+inline int bitbase_table(int type){
+	if(type == PAWN) return 0;
+	if(type == ROOK) return 1;
+	if(type == QUEEN) return 2;
+	return -1;
+}
+
+inline int bitbase_index(int strongmoves, int strongking, int weakking, int piece){
+	return strongmoves << 18 | strongking << 12 | weakking << 6 | piece;
+}
+
+inline int bitbase_get(const unsigned char* table, int index){
+	return (table[index >> 3] >> (index & 7)) & 1;
+}
+
+//read the tables written by bitbasegen, returns 0 if the file is missing or isn't one
+inline int bitbase_load(const char* filename){
+	FILE* file = fopen(filename, "rb");
+	if(!file){
+		return 0;
+	}
+	char magic[sizeof(BITBASE_MAGIC)];
+	int ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && !memcmp(magic, BITBASE_MAGIC, sizeof(magic))
+	      && fread(bitbase_data, 1, sizeof(bitbase_data), file) == sizeof(bitbase_data);
+	fclose(file);
+	if(!ok){
+		printf("Failed to read bitbases from %s\n", filename);
+	}
+	bitbase_loaded = ok;
+	return ok;
+}
+
+//look pos up if it's one of the endgames covered, returns 0 if it isn't, else 1 with result
+//set to BITBASE_WIN, BITBASE_DRAW or BITBASE_LOSS for the side to move
+inline int bitbase_probe(const position_t* pos, int* result){
+	if(!bitbase_loaded || popcount(pos -> occupied) != 3){
+		return 0;
+	}
+	int strong = popcount(pos -> colors[WHITE]) == 2 ? WHITE : BLACK;
+	bitboard_t piece = pos -> colors[strong] & ~pos -> pieces[KING][strong];
+	int sq = bitscan(piece);
+	int table = bitbase_table(pos -> squares[sq]);
+	if(table < 0){
+		*result = BITBASE_DRAW;
+		return 1;
+	}
+	//black as the strong side is white with the board turned over
+	int flip = strong == WHITE ? 0 : 56;
+	int index = bitbase_index(pos -> turn == strong, bitscan(pos -> pieces[KING][strong]) ^ flip, bitscan(pos -> pieces[KING][!strong]) ^ flip, sq ^ flip);
+	if(!bitbase_get(bitbase_data[table], index)){
+		*result = BITBASE_DRAW;
+	} else{
+		*result = pos -> turn == strong ? BITBASE_WIN : BITBASE_LOSS;
+	}
+	return 1;
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "bitboard.h"
+#include "bitbase.h"
+#include "nanotime.h"
+
+//works out the KQK, KRK and KPK bitbases and writes them to one file
+//usage: bitbasegen [-t threads] [file]    default file bitbases.bin
+//
+//every position starts unknown. each pass goes over the unknown ones and settles those whose
+//moves decide them: the strong side wins if any move reaches a won position, the weak side only
+//loses if every move does, and either side draws once a drawn position is in reach or every
+//move leads to one. passes repeat until one changes nothing, whatever is still unknown can't
+//be forced and is a draw. KPK goes last, since a pawn that promotes lands in the other two
+
+const unsigned char STATE_UNKNOWN = 0;
+const unsigned char STATE_WIN = 1;
+const unsigned char STATE_DRAW = 2;
+const unsigned char STATE_INVALID = 3;
+
+//positions handed to a thread at a time, so threads take turns along the table
+const int BLOCK = 4096;
+
+struct solver_s{
+	int type;
+	std::atomic<unsigned char>* states;
+	std::atomic<int> next;
+	std::atomic<int> changed;
+};
+
+typedef struct solver_s solver_t;
+
+//set up the position index stands for with the strong side as white, returns 0 if it can't occur
+int bitbase_setup(position_t* pos, int type, int index){
+	int strongmoves = index >> 18;
+	int strongking = (index >> 12) & 63;
+	int weakking = (index >> 6) & 63;
+	int piece = index & 63;
+	if(strongking == weakking || strongking == piece || weakking == piece || (king_attacks[strongking] & bit(weakking))){
+		return 0;
+	}
+	if(type == PAWN && (square_y(piece) == 0 || square_y(piece) == 7)){
+		return 0;
+	}
+	position_clear(pos);
+	position_put(pos, KING, WHITE, strongking);
+	position_put(pos, KING, BLACK, weakking);
+	position_put(pos, type, WHITE, piece);
+	pos -> turn = strongmoves ? WHITE : BLACK;
+	//the side that just moved can't have left its king in check
+	return !square_attacked(pos, bitscan(pos -> pieces[KING][!pos -> turn]), pos -> turn);
+}
+
+//state of the position a move leads to
+unsigned char bitbase_child(const solver_t* solver, const position_t* pos, int index, move_t move){
+	int strongking = (index >> 12) & 63;
+	int weakking = (index >> 6) & 63;
+	int piece = index & 63;
+	int from = move_from(move);
+	int to = move_to(move);
+
+	if(pos -> turn == BLACK){
+		//the bare king taking the piece leaves nothing to win with
+		if(to == piece){
+			return STATE_DRAW;
+		}
+		return solver -> states[bitbase_index(1, strongking, to, piece)].load(std::memory_order_relaxed);
+	}
+	if(from == strongking){
+		return solver -> states[bitbase_index(0, to, weakking, piece)].load(std::memory_order_relaxed);
+	}
+	if(move_flag(move) == MOVE_PROMOTION){
+		int table = bitbase_table(move_promotion(move));
+		if(table < 0){
+			return STATE_DRAW;
+		}
+		return bitbase_get(bitbase_data[table], bitbase_index(0, strongking, weakking, to)) ? STATE_WIN : STATE_DRAW;
+	}
+	return solver -> states[bitbase_index(0, strongking, weakking, to)].load(std::memory_order_relaxed);
+}
+
+//settle what can be settled in this position from its moves, STATE_UNKNOWN if nothing yet
+unsigned char bitbase_classify(const solver_t* solver, const position_t* pos, int index){
+	movelist_t list;
+	movegen_legal(pos, &list);
+	if(!list.count){
+		//mate is only possible against the bare king
+		return position_incheck(pos) && pos -> turn == BLACK ? STATE_WIN : STATE_DRAW;
+	}
+	int strong = pos -> turn == WHITE;
+	int wins = 0;
+	int draws = 0;
+	for(int i = 0; i < list.count; i++){
+		unsigned char state = bitbase_child(solver, pos, index, list.moves[i]);
+		wins += state == STATE_WIN;
+		draws += state == STATE_DRAW;
+	}
+	if(strong){
+		if(wins){
+			return STATE_WIN;
+		}
+		if(draws == list.count){
+			return STATE_DRAW;
+		}
+	} else{
+		if(draws){
+			return STATE_DRAW;
+		}
+		if(wins == list.count){
+			return STATE_WIN;
+		}
+	}
+	return STATE_UNKNOWN;
+}
+
+//first pass marks impossible positions, later ones settle unknown ones
+void solver_worker(solver_t* solver, int first){
+	position_t* pos = (position_t*)malloc(sizeof(position_t));
+	if(!pos){
+		printf("Failed to allocate memory\n");
+		exit(-1);
+	}
+	int start;
+	int changed = 0;
+	while((start = solver -> next.fetch_add(BLOCK)) < BITBASE_POSITIONS){
+		for(int index = start; index < start + BLOCK; index++){
+			if(solver -> states[index].load(std::memory_order_relaxed) != STATE_UNKNOWN){
+				continue;
+			}
+			if(!bitbase_setup(pos, solver -> type, index)){
+				if(first){
+					solver -> states[index].store(STATE_INVALID, std::memory_order_relaxed);
+				}
+				continue;
+			}
+			unsigned char state = bitbase_classify(solver, pos, index);
+			if(state != STATE_UNKNOWN){
+				solver -> states[index].store(state, std::memory_order_relaxed);
+				changed++;
+			}
+		}
+	}
+	solver -> changed += changed;
+	free(pos);
+}
+
+//solve one table into bitbase_data
+void bitbase_solve(int type, int threads){
+	const char* names = "PBNRQK";
+	unsigned long start = nanotime();
+	solver_t solver;
+	solver.type = type;
+	solver.states = new std::atomic<unsigned char>[BITBASE_POSITIONS];
+	for(int i = 0; i < BITBASE_POSITIONS; i++){
+		solver.states[i].store(STATE_UNKNOWN, std::memory_order_relaxed);
+	}
+
+	std::thread* workers = new std::thread[threads];
+	int passes = 0;
+	do{
+		solver.next = 0;
+		solver.changed = 0;
+		for(int t = 1; t < threads; t++){
+			workers[t] = std::thread(solver_worker, &solver, passes == 0);
+		}
+		solver_worker(&solver, passes == 0);
+		for(int t = 1; t < threads; t++){
+			workers[t].join();
+		}
+		passes++;
+	} while(solver.changed);
+
+	unsigned char* table = bitbase_data[bitbase_table(type)];
+	memset(table, 0, BITBASE_BYTES);
+	int wins = 0;
+	int legal = 0;
+	for(int i = 0; i < BITBASE_POSITIONS; i++){
+		unsigned char state = solver.states[i].load(std::memory_order_relaxed);
+		legal += state != STATE_INVALID;
+		if(state == STATE_WIN){
+			table[i >> 3] |= 1 << (i & 7);
+			wins++;
+		}
+	}
+	printf("K%cK positions %d won %d passes %d time %.3fs\n", names[type], legal, wins, passes, (nanotime() - start) / 1e9);
+
+	delete[] workers;
+	delete[] solver.states;
+}
+
+int main(int argc, char** argv){
+	int threads = std::thread::hardware_concurrency();
+	const char* filename = "bitbases.bin";
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-t") && i + 1 < argc){
+			threads = atoi(argv[++i]);
+		} else{
+			filename = argv[i];
+		}
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+
+	attacks_init();
+	bitbase_solve(QUEEN, threads);
+	bitbase_solve(ROOK, threads);
+	bitbase_solve(PAWN, threads);
+
+	FILE* file = fopen(filename, "wb");
+	if(!file){
+		printf("Failed to write %s\n", filename);
+		return -1;
+	}
+	fwrite(BITBASE_MAGIC, 1, sizeof(BITBASE_MAGIC), file);
+	fwrite(bitbase_data, 1, sizeof(bitbase_data), file);
+	fclose(file);
+	return 0;
+}
@@ -0,0 +1,1042 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+#include <stdio.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+const int PAWN = 0;
+const int BISHOP = 1;
+const int KNIGHT = 2;
+const int ROOK = 3;
+const int QUEEN = 4;
+const int KING = 5;
+
+const int BLACK = 0;
+const int WHITE = 1;
+
+//returned by position_pieceon for an empty square
+const int EMPTY = -1;
+
+//castling rights, one bit each
+const int CASTLE_WHITE_KING = 1;
+const int CASTLE_WHITE_QUEEN = 2;
+const int CASTLE_BLACK_KING = 4;
+const int CASTLE_BLACK_QUEEN = 8;
+
+//kinds of move, stored in the top two bits of a move
+const int MOVE_NORMAL = 0;
+const int MOVE_PROMOTION = 1;
+const int MOVE_PASSANT = 2;
+const int MOVE_CASTLE = 3;
+
+//results of position_status
+const int GAME_ONGOING = 0;
+const int GAME_CHECKMATE = 1;
+const int GAME_STALEMATE = 2;
+const int GAME_INSUFFICIENT = 3;
+const int GAME_REPETITION = 4;
+const int GAME_FIFTY = 5;
+
+//one bit per square, a1 = bit 0, h1 = bit 7, h8 = bit 63
+typedef uint64_t bitboard_t;
+
+const bitboard_t FILE_A = 0x0101010101010101ULL;
+const bitboard_t FILE_H = FILE_A << 7;
+const bitboard_t RANK_1 = 0xFFULL;
+const bitboard_t RANK_8 = RANK_1 << 56;
+
+//a move packed into 16 bits: from square in bits 0-5, to square in bits 6-11,
+//promotion piece minus one in bits 12-13 and the kind of move in bits 14-15
+typedef uint16_t move_t;
+
+//never generated, a1 to a1 is not a move
+const move_t MOVE_NONE = 0;
+
+inline move_t move_encode(int from, int to, int flag, int promotion){
+	return (move_t)(from | (to << 6) | ((flag == MOVE_PROMOTION ? promotion - 1 : 0) << 12) | (flag << 14));
+}
+
+inline int move_from(move_t move){
+	return move & 63;
+}
+
+inline int move_to(move_t move){
+	return (move >> 6) & 63;
+}
+
+inline int move_flag(move_t move){
+	return move >> 14;
+}
+
+//piece type a pawn becomes, only meaningful for MOVE_PROMOTION
+inline int move_promotion(move_t move){
+	return ((move >> 12) & 3) + 1;
+}
+
+//no position has more than 218 legal moves, leave room for pseudo-legal ones
+const int MAX_MOVES = 256;
+
+struct movelist_s{
+	move_t moves[MAX_MOVES];
+	int count;
+};
+
+typedef struct movelist_s movelist_t;
+
+//what a move destroys, kept so it can be taken back
+struct undo_s{
+	move_t move;
+	signed char captured;
+	unsigned char castling;
+	signed char passant;
+	short halfmove;
+	//zobrist key of the position before the move
+	uint64_t key;
+};
+
+typedef struct undo_s undo_t;
+
+//moves that can be taken back, the board UI trims older ones when it fills up
+const int MAX_HISTORY = 1024;
+
+struct position_s{
+	//one mask per piece type and color
+	bitboard_t pieces[6][2];
+	//occupancy per color and for the whole board
+	bitboard_t colors[2];
+	bitboard_t occupied;
+	//piece type on every square or EMPTY, for quick lookups
+	signed char squares[64];
+	int turn;
+	int castling;
+	//square a pawn can be taken on en passant, -1 if none
+	int passant;
+	//moves since the last capture or pawn move, and the move number starting at 1
+	int halfmove;
+	int fullmove;
+	//zobrist key, kept up to date as pieces and rights change
+	uint64_t key;
+	//undo records of the moves played, ply is the number in use
+	undo_t history[MAX_HISTORY];
+	int ply;
+};
+
+typedef struct position_s position_t;
+
+inline int square(int x, int y){
+	return y * 8 + x;
+}
+
+inline int square_x(int sq){
+	return sq & 7;
+}
+
+inline int square_y(int sq){
+	return sq >> 3;
+}
+
+inline bitboard_t bit(int sq){
+	return 1ULL << sq;
+}
+
+inline int popcount(bitboard_t b){
+	return __builtin_popcountll(b);
+}
+
+//index of lowest set bit, b must not be empty
+inline int bitscan(bitboard_t b){
+	return __builtin_ctzll(b);
+}
+
+//remove and return lowest set bit
+inline int poplsb(bitboard_t* b){
+	int sq = bitscan(*b);
+	*b &= *b - 1;
+	return sq;
+}
+
+inline bitboard_t knight_attacks[64];
+inline bitboard_t king_attacks[64];
+inline bitboard_t pawn_attacks[2][64];
+
+//squares strictly between two squares sharing a rank, file or diagonal, empty otherwise
+inline bitboard_t between_masks[64][64];
+//the whole rank, file or diagonal through two squares, empty if they share none
+inline bitboard_t line_masks[64][64];
+
+const int rook_directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+const int bishop_directions[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+//walk each direction until the edge or the first blocker, blocker included,
+//only used to build the lookup tables below
+inline bitboard_t sliding_attacks(int sq, bitboard_t occupied, const int directions[4][2]){
+	bitboard_t attacks = 0;
+	for(int d = 0; d < 4; d++){
+		int x = square_x(sq) + directions[d][0];
+		int y = square_y(sq) + directions[d][1];
+		while(x >= 0 && x < 8 && y >= 0 && y < 8){
+			attacks |= bit(square(x, y));
+			if(occupied & bit(square(x, y))){
+				break;
+			}
+			x += directions[d][0];
+			y += directions[d][1];
+		}
+	}
+	return attacks;
+}
+
+//slider attacks are looked up by hashing the blockers on the slider's lines into a table index,
+//with BMI2 the index is the blockers squeezed together by pext, otherwise a magic multiplication
+struct magic_s{
+	//squares whose occupancy changes the attack set, board edges excluded
+	bitboard_t mask;
+	bitboard_t magic;
+	bitboard_t* attacks;
+	int shift;
+};
+
+typedef struct magic_s magic_t;
+
+inline magic_t rook_magics[64];
+inline magic_t bishop_magics[64];
+
+//every square's block of attack sets, sized for the sum of 2^(relevant bits) over all squares
+inline bitboard_t rook_table[0x19000];
+inline bitboard_t bishop_table[0x1480];
+
+inline unsigned magic_index(const magic_t* m, bitboard_t occupied){
+#ifdef __BMI2__
+	return (unsigned)_pext_u64(occupied, m -> mask);
+#else
+	return (unsigned)(((occupied & m -> mask) * m -> magic) >> m -> shift);
+#endif
+}
+
+inline bitboard_t rook_attacks(int sq, bitboard_t occupied){
+	const magic_t* m = &rook_magics[sq];
+	return m -> attacks[magic_index(m, occupied)];
+}
+
+inline bitboard_t bishop_attacks(int sq, bitboard_t occupied){
+	const magic_t* m = &bishop_magics[sq];
+	return m -> attacks[magic_index(m, occupied)];
+}
+
+inline bitboard_t queen_attacks(int sq, bitboard_t occupied){
+	return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+}
+
+//xorshift generator, seeded the same every run so the magics found are always the same
+inline uint64_t magic_random(uint64_t* state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+//random keys xored together to hash a position, one per piece on each square,
+//castling rights combination, en passant file and for black to move
+inline uint64_t zobrist_pieces[6][2][64];
+inline uint64_t zobrist_castling[16];
+inline uint64_t zobrist_passant[8];
+inline uint64_t zobrist_turn;
+
+inline void zobrist_init(){
+	uint64_t state = 0x9E3779B97F4A7C15ULL;
+	for(int type = PAWN; type <= KING; type++){
+		for(int sq = 0; sq < 64; sq++){
+			zobrist_pieces[type][BLACK][sq] = magic_random(&state);
+			zobrist_pieces[type][WHITE][sq] = magic_random(&state);
+		}
+	}
+	for(int i = 0; i < 16; i++){
+		zobrist_castling[i] = magic_random(&state);
+	}
+	for(int i = 0; i < 8; i++){
+		zobrist_passant[i] = magic_random(&state);
+	}
+	zobrist_turn = magic_random(&state);
+}
+
+//fill one slider's magics and table, searching for a magic per square that maps
+//every blocker subset to a slot holding the right attack set
+inline void magics_init(magic_t* magics, bitboard_t* table, const int directions[4][2]){
+	static bitboard_t occupancy[4096];
+	static bitboard_t reference[4096];
+	static int epoch[4096];
+	//per rank seeds known to find every magic after few attempts
+	const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+	int attempt = 0;
+	bitboard_t* attacks = table;
+	//attempt starts over each call, so the last call's epochs would turn away every candidate
+	//until it caught up
+	for(int i = 0; i < 4096; i++){
+		epoch[i] = 0;
+	}
+
+	for(int sq = 0; sq < 64; sq++){
+		magic_t* m = &magics[sq];
+		bitboard_t edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * square_y(sq)))) | ((FILE_A | FILE_H) & ~(FILE_A << square_x(sq)));
+		m -> mask = sliding_attacks(sq, 0, directions) & ~edges;
+		m -> shift = 64 - popcount(m -> mask);
+		m -> attacks = attacks;
+
+		//enumerate every subset of the mask with the carry-rippler trick
+		int size = 0;
+		bitboard_t subset = 0;
+		do{
+			occupancy[size] = subset;
+			reference[size] = sliding_attacks(sq, subset, directions);
+			size++;
+			subset = (subset - m -> mask) & m -> mask;
+		} while(subset);
+
+#ifdef __BMI2__
+		for(int i = 0; i < size; i++){
+			m -> attacks[magic_index(m, occupancy[i])] = reference[i];
+		}
+#else
+		//try sparse random numbers until one has no destructive collisions
+		uint64_t state = seeds[square_y(sq)];
+		int i = 0;
+		while(i < size){
+			do{
+				m -> magic = magic_random(&state) & magic_random(&state) & magic_random(&state);
+			} while(popcount((m -> mask * m -> magic) >> 56) < 6);
+			attempt++;
+			for(i = 0; i < size; i++){
+				unsigned index = magic_index(m, occupancy[i]);
+				if(epoch[index] < attempt){
+					epoch[index] = attempt;
+					m -> attacks[index] = reference[i];
+				} else
+				if(m -> attacks[index] != reference[i]){
+					break;
+				}
+			}
+		}
+#endif
+		attacks += size;
+	}
+}
+
+//attack set of any piece type standing on sq
+inline bitboard_t piece_attacks(int type, int color, int sq, bitboard_t occupied){
+	if(type == PAWN){
+		return pawn_attacks[color][sq];
+	} else
+	if(type == BISHOP){
+		return bishop_attacks(sq, occupied);
+	} else
+	if(type == KNIGHT){
+		return knight_attacks[sq];
+	} else
+	if(type == ROOK){
+		return rook_attacks(sq, occupied);
+	} else
+	if(type == QUEEN){
+		return queen_attacks(sq, occupied);
+	}
+	return king_attacks[sq];
+}
+
+//fill the leaper, slider and hashing tables, call once before generating moves
+inline void attacks_init(){
+	const int knight_steps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+	const int king_steps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+	for(int sq = 0; sq < 64; sq++){
+		int x = square_x(sq);
+		int y = square_y(sq);
+		knight_attacks[sq] = 0;
+		king_attacks[sq] = 0;
+		for(int i = 0; i < 8; i++){
+			int nx = x + knight_steps[i][0];
+			int ny = y + knight_steps[i][1];
+			if(nx >= 0 && nx < 8 && ny >= 0 && ny < 8){
+				knight_attacks[sq] |= bit(square(nx, ny));
+			}
+			nx = x + king_steps[i][0];
+			ny = y + king_steps[i][1];
+			if(nx >= 0 && nx < 8 && ny >= 0 && ny < 8){
+				king_attacks[sq] |= bit(square(nx, ny));
+			}
+		}
+		pawn_attacks[WHITE][sq] = 0;
+		pawn_attacks[BLACK][sq] = 0;
+		if(y < 7){
+			if(x > 0) pawn_attacks[WHITE][sq] |= bit(square(x - 1, y + 1));
+			if(x < 7) pawn_attacks[WHITE][sq] |= bit(square(x + 1, y + 1));
+		}
+		if(y > 0){
+			if(x > 0) pawn_attacks[BLACK][sq] |= bit(square(x - 1, y - 1));
+			if(x < 7) pawn_attacks[BLACK][sq] |= bit(square(x + 1, y - 1));
+		}
+	}
+	magics_init(rook_magics, rook_table, rook_directions);
+	magics_init(bishop_magics, bishop_table, bishop_directions);
+	zobrist_init();
+
+	for(int a = 0; a < 64; a++){
+		for(int b = 0; b < 64; b++){
+			between_masks[a][b] = 0;
+			line_masks[a][b] = 0;
+			if(a == b){
+				continue;
+			}
+			if(rook_attacks(a, 0) & bit(b)){
+				between_masks[a][b] = rook_attacks(a, bit(b)) & rook_attacks(b, bit(a));
+				line_masks[a][b] = (rook_attacks(a, 0) & rook_attacks(b, 0)) | bit(a) | bit(b);
+			} else
+			if(bishop_attacks(a, 0) & bit(b)){
+				between_masks[a][b] = bishop_attacks(a, bit(b)) & bishop_attacks(b, bit(a));
+				line_masks[a][b] = (bishop_attacks(a, 0) & bishop_attacks(b, 0)) | bit(a) | bit(b);
+			}
+		}
+	}
+}
+
+inline int position_pieceon(const position_t* pos, int sq){
+	return pos -> squares[sq];
+}
+
+//color of the piece on sq, only meaningful if the square is occupied
+inline int position_coloron(const position_t* pos, int sq){
+	return (pos -> colors[WHITE] & bit(sq)) ? WHITE : BLACK;
+}
+
+inline void position_put(position_t* pos, int type, int color, int sq){
+	pos -> pieces[type][color] |= bit(sq);
+	pos -> colors[color] |= bit(sq);
+	pos -> occupied |= bit(sq);
+	pos -> squares[sq] = type;
+	pos -> key ^= zobrist_pieces[type][color][sq];
+}
+
+inline void position_remove(position_t* pos, int sq){
+	int type = pos -> squares[sq];
+	int color = position_coloron(pos, sq);
+	pos -> pieces[type][color] &= ~bit(sq);
+	pos -> colors[color] &= ~bit(sq);
+	pos -> occupied &= ~bit(sq);
+	pos -> squares[sq] = EMPTY;
+	pos -> key ^= zobrist_pieces[type][color][sq];
+}
+
+inline void position_clear(position_t* pos){
+	for(int type = PAWN; type <= KING; type++){
+		pos -> pieces[type][BLACK] = 0;
+		pos -> pieces[type][WHITE] = 0;
+	}
+	pos -> colors[BLACK] = 0;
+	pos -> colors[WHITE] = 0;
+	pos -> occupied = 0;
+	for(int sq = 0; sq < 64; sq++){
+		pos -> squares[sq] = EMPTY;
+	}
+	pos -> turn = WHITE;
+	pos -> castling = 0;
+	pos -> passant = -1;
+	pos -> halfmove = 0;
+	pos -> fullmove = 1;
+	pos -> key = 0;
+	pos -> ply = 0;
+}
+
+//key of everything but the pieces, which position_put and position_remove hash as they go
+inline uint64_t position_statekey(const position_t* pos){
+	uint64_t key = zobrist_castling[pos -> castling];
+	//the en passant file only counts when a pawn is there to take, or the same position reached
+	//with and without a double push would never repeat
+	if(pos -> passant >= 0 && (pawn_attacks[!pos -> turn][pos -> passant] & pos -> pieces[PAWN][pos -> turn])){
+		key ^= zobrist_passant[square_x(pos -> passant)];
+	}
+	if(pos -> turn == BLACK){
+		key ^= zobrist_turn;
+	}
+	return key;
+}
+
+//set up the standard starting position
+inline void position_start(position_t* pos){
+	const int backrank[8] = {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK};
+	position_clear(pos);
+	for(int x = 0; x < 8; x++){
+		position_put(pos, backrank[x], WHITE, square(x, 0));
+		position_put(pos, PAWN, WHITE, square(x, 1));
+		position_put(pos, PAWN, BLACK, square(x, 6));
+		position_put(pos, backrank[x], BLACK, square(x, 7));
+	}
+	pos -> castling = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN | CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN;
+	pos -> key ^= position_statekey(pos);
+}
+
+//load a position from Forsyth-Edwards Notation, returns 0 if the string is malformed
+inline int position_fromfen(position_t* pos, const char* fen){
+	const char* letters = "pbnrqk";
+	position_clear(pos);
+
+	//piece placement, rank 8 first
+	int x = 0;
+	int y = 7;
+	for(; *fen && *fen != ' '; fen++){
+		if(*fen == '/'){
+			x = 0;
+			y--;
+		} else
+		if(*fen >= '1' && *fen <= '8'){
+			x += *fen - '0';
+		} else{
+			int lower = *fen | 0x20;
+			int type = 0;
+			while(letters[type] && letters[type] != lower){
+				type++;
+			}
+			if(!letters[type] || x > 7 || y < 0){
+				return 0;
+			}
+			position_put(pos, type, lower == *fen ? BLACK : WHITE, square(x, y));
+			x++;
+		}
+	}
+	if(*fen++ != ' '){
+		return 0;
+	}
+
+	//side to move
+	if(*fen == 'w'){
+		pos -> turn = WHITE;
+	} else
+	if(*fen == 'b'){
+		pos -> turn = BLACK;
+	} else{
+		return 0;
+	}
+	fen++;
+
+	//castling rights, "-" for none
+	while(*fen == ' '){
+		fen++;
+	}
+	for(; *fen && *fen != ' '; fen++){
+		if(*fen == 'K') pos -> castling |= CASTLE_WHITE_KING;
+		if(*fen == 'Q') pos -> castling |= CASTLE_WHITE_QUEEN;
+		if(*fen == 'k') pos -> castling |= CASTLE_BLACK_KING;
+		if(*fen == 'q') pos -> castling |= CASTLE_BLACK_QUEEN;
+	}
+
+	//en passant square, "-" for none
+	while(*fen == ' '){
+		fen++;
+	}
+	if(fen[0] >= 'a' && fen[0] <= 'h' && fen[1] >= '1' && fen[1] <= '8'){
+		pos -> passant = square(fen[0] - 'a', fen[1] - '1');
+	}
+
+	//rights the board doesn't back up are dropped, or a castle or en passant capture would move
+	//pieces that aren't there
+	const int rights[4] = {CASTLE_WHITE_KING, CASTLE_WHITE_QUEEN, CASTLE_BLACK_KING, CASTLE_BLACK_QUEEN};
+	const int rooks[4] = {square(7, 0), square(0, 0), square(7, 7), square(0, 7)};
+	for(int i = 0; i < 4; i++){
+		int color = i < 2 ? WHITE : BLACK;
+		int king = square(4, color == WHITE ? 0 : 7);
+		if(!(pos -> pieces[KING][color] & bit(king)) || !(pos -> pieces[ROOK][color] & bit(rooks[i]))){
+			pos -> castling &= ~rights[i];
+		}
+	}
+	//the square has to be empty, behind a pawn of the side that just moved its two squares
+	if(pos -> passant >= 0){
+		int y = pos -> turn == WHITE ? 5 : 2;
+		int pawn = pos -> turn == WHITE ? pos -> passant - 8 : pos -> passant + 8;
+		if(square_y(pos -> passant) != y || pos -> squares[pos -> passant] != EMPTY
+		  || !(pos -> pieces[PAWN][!pos -> turn] & bit(pawn))){
+			pos -> passant = -1;
+		}
+	}
+
+	//move counters, optional
+	while(*fen && *fen != ' '){
+		fen++;
+	}
+	int halfmove, fullmove;
+	if(sscanf(fen, "%d %d", &halfmove, &fullmove) == 2){
+		pos -> halfmove = halfmove;
+		pos -> fullmove = fullmove;
+	}
+	pos -> key ^= position_statekey(pos);
+	return popcount(pos -> pieces[KING][WHITE]) == 1 && popcount(pos -> pieces[KING][BLACK]) == 1;
+}
+
+//longest Forsyth-Edwards string position_tofen can write, with its terminator
+const int FEN_MAX = 96;
+
+//write the position in Forsyth-Edwards Notation, out needs room for FEN_MAX chars
+inline void position_tofen(const position_t* pos, char* out){
+	const char* letters = "pbnrqk";
+
+	//piece placement, rank 8 first
+	for(int y = 7; y >= 0; y--){
+		int empty = 0;
+		for(int x = 0; x < 8; x++){
+			int sq = square(x, y);
+			if(pos -> squares[sq] == EMPTY){
+				empty++;
+				continue;
+			}
+			if(empty){
+				*out++ = '0' + empty;
+				empty = 0;
+			}
+			char letter = letters[(int)pos -> squares[sq]];
+			*out++ = (pos -> colors[WHITE] & bit(sq)) ? letter - 0x20 : letter;
+		}
+		if(empty){
+			*out++ = '0' + empty;
+		}
+		if(y){
+			*out++ = '/';
+		}
+	}
+
+	*out++ = ' ';
+	*out++ = pos -> turn == WHITE ? 'w' : 'b';
+	*out++ = ' ';
+	if(!pos -> castling){
+		*out++ = '-';
+	}
+	if(pos -> castling & CASTLE_WHITE_KING) *out++ = 'K';
+	if(pos -> castling & CASTLE_WHITE_QUEEN) *out++ = 'Q';
+	if(pos -> castling & CASTLE_BLACK_KING) *out++ = 'k';
+	if(pos -> castling & CASTLE_BLACK_QUEEN) *out++ = 'q';
+	*out++ = ' ';
+	if(pos -> passant >= 0){
+		*out++ = 'a' + square_x(pos -> passant);
+		*out++ = '1' + square_y(pos -> passant);
+	} else{
+		*out++ = '-';
+	}
+	snprintf(out, 24, " %d %d", pos -> halfmove, pos -> fullmove);
+}
+
+//coordinate notation such as e2e4 or e7e8q, out needs room for 6 chars
+inline void move_tostring(move_t move, char* out){
+	out[0] = 'a' + square_x(move_from(move));
+	out[1] = '1' + square_y(move_from(move));
+	out[2] = 'a' + square_x(move_to(move));
+	out[3] = '1' + square_y(move_to(move));
+	out[4] = move_flag(move) == MOVE_PROMOTION ? "pbnrqk"[move_promotion(move)] : '\0';
+	out[5] = '\0';
+}
+
+//pieces of both colors attacking sq, with sliders blocked by occupied
+inline bitboard_t attackers_to(const position_t* pos, int sq, bitboard_t occupied){
+	bitboard_t rooks = pos -> pieces[ROOK][WHITE] | pos -> pieces[ROOK][BLACK] | pos -> pieces[QUEEN][WHITE] | pos -> pieces[QUEEN][BLACK];
+	bitboard_t bishops = pos -> pieces[BISHOP][WHITE] | pos -> pieces[BISHOP][BLACK] | pos -> pieces[QUEEN][WHITE] | pos -> pieces[QUEEN][BLACK];
+	return (pawn_attacks[BLACK][sq] & pos -> pieces[PAWN][WHITE])
+	     | (pawn_attacks[WHITE][sq] & pos -> pieces[PAWN][BLACK])
+	     | (knight_attacks[sq] & (pos -> pieces[KNIGHT][WHITE] | pos -> pieces[KNIGHT][BLACK]))
+	     | (king_attacks[sq] & (pos -> pieces[KING][WHITE] | pos -> pieces[KING][BLACK]))
+	     | (rook_attacks(sq, occupied) & rooks)
+	     | (bishop_attacks(sq, occupied) & bishops);
+}
+
+//whether any piece of color by attacks sq
+inline int square_attacked(const position_t* pos, int sq, int by){
+	return (attackers_to(pos, sq, pos -> occupied) & pos -> colors[by]) != 0;
+}
+
+inline int position_incheck(const position_t* pos){
+	return square_attacked(pos, bitscan(pos -> pieces[KING][pos -> turn]), !pos -> turn);
+}
+
+inline void movelist_add(movelist_t* list, int from, int to, int flag, int promotion){
+	list -> moves[list -> count++] = move_encode(from, to, flag, promotion);
+}
+
+//add one move per set bit in targets, all starting at from
+inline void movelist_addtargets(movelist_t* list, int from, bitboard_t targets){
+	while(targets){
+		movelist_add(list, from, poplsb(&targets), MOVE_NORMAL, 0);
+	}
+}
+
+inline void movelist_addpromotions(movelist_t* list, int from, int to){
+	movelist_add(list, from, to, MOVE_PROMOTION, QUEEN);
+	movelist_add(list, from, to, MOVE_PROMOTION, ROOK);
+	movelist_add(list, from, to, MOVE_PROMOTION, BISHOP);
+	movelist_add(list, from, to, MOVE_PROMOTION, KNIGHT);
+}
+
+//shift a bitboard one rank towards the opponent of color
+inline bitboard_t pawn_push(bitboard_t b, int color){
+	return color == WHITE ? b << 8 : b >> 8;
+}
+
+inline void movelist_addpawn(movelist_t* list, int from, int to){
+	if(square_y(to) == 0 || square_y(to) == 7){
+		movelist_addpromotions(list, from, to);
+	} else{
+		movelist_add(list, from, to, MOVE_NORMAL, 0);
+	}
+}
+
+//allied pieces that are the only blocker between their king and an enemy slider
+inline bitboard_t pinned_pieces(const position_t* pos, int color, int king){
+	int them = !color;
+	bitboard_t snipers = (rook_attacks(king, 0) & (pos -> pieces[ROOK][them] | pos -> pieces[QUEEN][them]))
+	                   | (bishop_attacks(king, 0) & (pos -> pieces[BISHOP][them] | pos -> pieces[QUEEN][them]));
+	bitboard_t pinned = 0;
+	while(snipers){
+		bitboard_t blockers = between_masks[king][poplsb(&snipers)] & pos -> occupied;
+		if(blockers && !(blockers & (blockers - 1)) && (blockers & pos -> colors[color])){
+			pinned |= blockers;
+		}
+	}
+	return pinned;
+}
+
+//pawn and piece moves other than king moves, castling and en passant, landing only on target,
+//pinned pieces only move along the line through their king
+inline void movegen_pieces(const position_t* pos, movelist_t* list, bitboard_t target, bitboard_t pinned, int king){
+	int us = pos -> turn;
+	bitboard_t enemy = pos -> colors[!us];
+	bitboard_t empty = ~pos -> occupied;
+	int forward = us == WHITE ? 8 : -8;
+	bitboard_t lastrank = us == WHITE ? RANK_8 : RANK_1;
+	bitboard_t doublerank = us == WHITE ? (RANK_1 << 24) : (RANK_1 << 32);
+
+	//pawn pushes of unpinned pawns, one and two squares
+	bitboard_t pawns = pos -> pieces[PAWN][us] & ~pinned;
+	bitboard_t single = pawn_push(pawns, us) & empty;
+	bitboard_t twice = pawn_push(single, us) & empty & doublerank & target;
+	single &= target;
+	bitboard_t targets = single & ~lastrank;
+	while(targets){
+		int to = poplsb(&targets);
+		movelist_add(list, to - forward, to, MOVE_NORMAL, 0);
+	}
+	targets = single & lastrank;
+	while(targets){
+		int to = poplsb(&targets);
+		movelist_addpromotions(list, to - forward, to);
+	}
+	while(twice){
+		int to = poplsb(&twice);
+		movelist_add(list, to - 2 * forward, to, MOVE_NORMAL, 0);
+	}
+
+	//pinned pawns may still push along a file pin
+	bitboard_t pieces = pos -> pieces[PAWN][us] & pinned;
+	while(pieces){
+		int from = poplsb(&pieces);
+		int to = from + forward;
+		bitboard_t allowed = line_masks[king][from] & target;
+		if(empty & bit(to)){
+			if(allowed & bit(to)){
+				movelist_addpawn(list, from, to);
+			}
+			if(pawn_push(bit(to), us) & allowed & empty & doublerank){
+				movelist_add(list, from, to + forward, MOVE_NORMAL, 0);
+			}
+		}
+	}
+
+	//pawn captures
+	pieces = pos -> pieces[PAWN][us];
+	while(pieces){
+		int from = poplsb(&pieces);
+		targets = pawn_attacks[us][from] & enemy & target;
+		if(pinned & bit(from)){
+			targets &= line_masks[king][from];
+		}
+		while(targets){
+			movelist_addpawn(list, from, poplsb(&targets));
+		}
+	}
+
+	//every other piece moves to any attacked square not holding an allied piece
+	for(int type = BISHOP; type <= QUEEN; type++){
+		pieces = pos -> pieces[type][us];
+		while(pieces){
+			int from = poplsb(&pieces);
+			targets = piece_attacks(type, us, from, pos -> occupied) & target;
+			if(pinned & bit(from)){
+				targets &= line_masks[king][from];
+			}
+			movelist_addtargets(list, from, targets);
+		}
+	}
+}
+
+//all moves that follow piece movement rules, the king may be left in check
+inline void movegen_pseudo(const position_t* pos, movelist_t* list){
+	int us = pos -> turn;
+	bitboard_t own = pos -> colors[us];
+
+	list -> count = 0;
+	movegen_pieces(pos, list, ~own, 0, 0);
+
+	if(pos -> passant >= 0){
+		bitboard_t pawns = pawn_attacks[!us][pos -> passant] & pos -> pieces[PAWN][us];
+		while(pawns){
+			movelist_add(list, poplsb(&pawns), pos -> passant, MOVE_PASSANT, 0);
+		}
+	}
+
+	int king = bitscan(pos -> pieces[KING][us]);
+	movelist_addtargets(list, king, king_attacks[king] & ~own);
+
+	//castling, rights are dropped once the king or rook moves so only the path needs to be empty
+	int backrank = us == WHITE ? 0 : 56;
+	int kingside = us == WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+	int queenside = us == WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+	if((pos -> castling & kingside) && !(pos -> occupied & (bit(backrank + 5) | bit(backrank + 6)))){
+		movelist_add(list, backrank + 4, backrank + 6, MOVE_CASTLE, 0);
+	}
+	if((pos -> castling & queenside) && !(pos -> occupied & (bit(backrank + 1) | bit(backrank + 2) | bit(backrank + 3)))){
+		movelist_add(list, backrank + 4, backrank + 2, MOVE_CASTLE, 0);
+	}
+}
+
+//only moves that don't leave the mover's king attacked, checkers and pins are found once
+//up front so no move has to be played to be tested
+inline void movegen_legal(const position_t* pos, movelist_t* list){
+	int us = pos -> turn;
+	int them = !us;
+	bitboard_t own = pos -> colors[us];
+	bitboard_t enemy = pos -> colors[them];
+	int king = bitscan(pos -> pieces[KING][us]);
+	bitboard_t checkers = attackers_to(pos, king, pos -> occupied) & enemy;
+
+	list -> count = 0;
+
+	//king steps, tested with the king lifted off the board so it can't hide behind itself from a slider
+	bitboard_t occupied = pos -> occupied ^ bit(king);
+	bitboard_t targets = king_attacks[king] & ~own;
+	while(targets){
+		int to = poplsb(&targets);
+		if(!(attackers_to(pos, to, occupied) & enemy)){
+			movelist_add(list, king, to, MOVE_NORMAL, 0);
+		}
+	}
+
+	//in double check only the king can move
+	if(checkers & (checkers - 1)){
+		return;
+	}
+
+	//in check every other move has to take the checker or step in its way
+	bitboard_t target = ~own;
+	if(checkers){
+		target = checkers | between_masks[king][bitscan(checkers)];
+	}
+	movegen_pieces(pos, list, target, pinned_pieces(pos, us, king), king);
+
+	//en passant removes two pieces from one rank, so it is checked by looking at the board after it
+	if(pos -> passant >= 0){
+		int taken = pos -> passant + (us == WHITE ? -8 : 8);
+		bitboard_t pawns = pawn_attacks[them][pos -> passant] & pos -> pieces[PAWN][us];
+		while(pawns){
+			int from = poplsb(&pawns);
+			occupied = (pos -> occupied ^ bit(from) ^ bit(taken)) | bit(pos -> passant);
+			if(!(attackers_to(pos, king, occupied) & enemy & ~bit(taken))){
+				movelist_add(list, from, pos -> passant, MOVE_PASSANT, 0);
+			}
+		}
+	}
+
+	//castling, not out of, through or into check
+	if(!checkers){
+		int backrank = us == WHITE ? 0 : 56;
+		int kingside = us == WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+		int queenside = us == WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+		if((pos -> castling & kingside) && !(pos -> occupied & (bit(backrank + 5) | bit(backrank + 6)))
+		  && !square_attacked(pos, backrank + 5, them) && !square_attacked(pos, backrank + 6, them)){
+			movelist_add(list, backrank + 4, backrank + 6, MOVE_CASTLE, 0);
+		}
+		if((pos -> castling & queenside) && !(pos -> occupied & (bit(backrank + 1) | bit(backrank + 2) | bit(backrank + 3)))
+		  && !square_attacked(pos, backrank + 3, them) && !square_attacked(pos, backrank + 2, them)){
+			movelist_add(list, backrank + 4, backrank + 2, MOVE_CASTLE, 0);
+		}
+	}
+}
+
+//neither side has enough material left to ever mate
+inline int position_insufficient(const position_t* pos){
+	for(int color = BLACK; color <= WHITE; color++){
+		if(pos -> pieces[PAWN][color] | pos -> pieces[ROOK][color] | pos -> pieces[QUEEN][color]){
+			return 0;
+		}
+	}
+	bitboard_t minors = pos -> pieces[BISHOP][WHITE] | pos -> pieces[BISHOP][BLACK] | pos -> pieces[KNIGHT][WHITE] | pos -> pieces[KNIGHT][BLACK];
+	return popcount(minors) <= 1;
+}
+
+//how many earlier positions in the history match this one, only positions since the
+//last capture or pawn move can, and only every other one has the same side to move
+inline int position_repetitions(const position_t* pos){
+	int count = 0;
+	int oldest = pos -> ply - pos -> halfmove;
+	if(oldest < 0){
+		oldest = 0;
+	}
+	for(int i = pos -> ply - 2; i >= oldest; i -= 2){
+		if(pos -> history[i].key == pos -> key){
+			count++;
+		}
+	}
+	return count;
+}
+
+//whether the game is over in this position, and how
+inline int position_status(const position_t* pos){
+	movelist_t list;
+	movegen_legal(pos, &list);
+	if(!list.count){
+		return position_incheck(pos) ? GAME_CHECKMATE : GAME_STALEMATE;
+	}
+	if(position_insufficient(pos)){
+		return GAME_INSUFFICIENT;
+	}
+	if(position_repetitions(pos) >= 2){
+		return GAME_REPETITION;
+	}
+	if(pos -> halfmove >= 100){
+		return GAME_FIFTY;
+	}
+	return GAME_ONGOING;
+}
+
+//castling rights that survive a move touching sq
+inline int castling_mask(int sq){
+	if(sq == 0) return ~CASTLE_WHITE_QUEEN;
+	if(sq == 7) return ~CASTLE_WHITE_KING;
+	if(sq == 4) return ~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN);
+	if(sq == 56) return ~CASTLE_BLACK_QUEEN;
+	if(sq == 63) return ~CASTLE_BLACK_KING;
+	if(sq == 60) return ~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN);
+	return ~0;
+}
+
+//move whatever stands on from to the empty square to
+inline void position_movepiece(position_t* pos, int from, int to){
+	int type = pos -> squares[from];
+	int color = position_coloron(pos, from);
+	bitboard_t mask = bit(from) | bit(to);
+	pos -> pieces[type][color] ^= mask;
+	pos -> colors[color] ^= mask;
+	pos -> occupied ^= mask;
+	pos -> squares[to] = type;
+	pos -> squares[from] = EMPTY;
+	pos -> key ^= zobrist_pieces[type][color][from] ^ zobrist_pieces[type][color][to];
+}
+
+//rook squares of a castling move, by the king's destination
+inline void castling_rook(int from, int to, int* rook_from, int* rook_to){
+	*rook_from = to > from ? from + 3 : from - 4;
+	*rook_to = to > from ? from + 1 : from - 1;
+}
+
+//play a move generated for this position and pass the turn, pushing an undo record
+inline void position_makemove(position_t* pos, move_t move){
+	int us = pos -> turn;
+	int from = move_from(move);
+	int to = move_to(move);
+	int flag = move_flag(move);
+	int type = pos -> squares[from];
+	undo_t* undo = &pos -> history[pos -> ply++];
+
+	undo -> move = move;
+	undo -> captured = EMPTY;
+	undo -> castling = pos -> castling;
+	undo -> passant = pos -> passant;
+	undo -> halfmove = pos -> halfmove;
+	undo -> key = pos -> key;
+
+	//take the old rights and en passant file out of the key, the new ones go in at the end
+	pos -> key ^= position_statekey(pos);
+
+	if(flag == MOVE_PASSANT){
+		//the taken pawn sits behind the destination square
+		undo -> captured = PAWN;
+		position_remove(pos, to + (us == WHITE ? -8 : 8));
+	} else
+	if(pos -> squares[to] != EMPTY){
+		//"take" any piece at the destination
+		undo -> captured = pos -> squares[to];
+		position_remove(pos, to);
+	}
+
+	if(flag == MOVE_PROMOTION){
+		position_remove(pos, from);
+		position_put(pos, move_promotion(move), us, to);
+	} else{
+		position_movepiece(pos, from, to);
+	}
+
+	if(flag == MOVE_CASTLE){
+		//move the rook to the other side of the king
+		int rook_from, rook_to;
+		castling_rook(from, to, &rook_from, &rook_to);
+		position_movepiece(pos, rook_from, rook_to);
+	}
+
+	pos -> passant = (type == PAWN && (to - from == 16 || from - to == 16)) ? (from + to) / 2 : -1;
+	pos -> castling &= castling_mask(from) & castling_mask(to);
+	pos -> halfmove = (type == PAWN || undo -> captured != EMPTY) ? 0 : pos -> halfmove + 1;
+	if(us == BLACK){
+		pos -> fullmove++;
+	}
+	pos -> turn = !us;
+	pos -> key ^= position_statekey(pos);
+}
+
+//take back the last move played with position_makemove
+inline void position_unmakemove(position_t* pos){
+	undo_t* undo = &pos -> history[--pos -> ply];
+	int us = !pos -> turn;
+	int from = move_from(undo -> move);
+	int to = move_to(undo -> move);
+	int flag = move_flag(undo -> move);
+
+	pos -> turn = us;
+	if(flag == MOVE_PROMOTION){
+		position_remove(pos, to);
+		position_put(pos, PAWN, us, from);
+	} else{
+		position_movepiece(pos, to, from);
+	}
+
+	if(flag == MOVE_CASTLE){
+		int rook_from, rook_to;
+		castling_rook(from, to, &rook_from, &rook_to);
+		position_movepiece(pos, rook_to, rook_from);
+	}
+
+	if(undo -> captured != EMPTY){
+		position_put(pos, undo -> captured, !us, flag == MOVE_PASSANT ? to + (us == WHITE ? -8 : 8) : to);
+	}
+
+	pos -> castling = undo -> castling;
+	pos -> passant = undo -> passant;
+	pos -> halfmove = undo -> halfmove;
+	pos -> key = undo -> key;
+	if(us == BLACK){
+		pos -> fullmove--;
+	}
+}
+
+//forget all but the newest keep undo records, so a long game never runs out of room
+inline void position_trimhistory(position_t* pos, int keep){
+	if(pos -> ply > keep){
+		for(int i = 0; i < keep; i++){
+			pos -> history[i] = pos -> history[pos -> ply - keep + i];
+		}
+		pos -> ply = keep;
+	}
+}
+
+#endif
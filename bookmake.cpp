@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bitboard.h"
+#include "pgn.h"
+#include "book.h"
+
+//build an opening book from PGN games
+//usage: bookmake [-p plies] book.bin file.pgn...
+//every move in the first plies (default 20) of every game from the standard start goes in,
+//weighted 2 for a win by the side that played it, 1 for a draw or unknown result, 0 for a loss
+
+struct bookentry_s{
+	uint64_t key;
+	uint16_t move;
+	uint32_t weight;
+};
+
+typedef struct bookentry_s bookentry_t;
+
+int bookentry_compare(const void* a, const void* b){
+	const bookentry_t* x = (const bookentry_t*)a;
+	const bookentry_t* y = (const bookentry_t*)b;
+	if(x -> key != y -> key){
+		return x -> key < y -> key ? -1 : 1;
+	}
+	return (int)x -> move - (int)y -> move;
+}
+
+bookentry_t* entries;
+uint64_t entrycount = 0;
+uint64_t entrycapacity = 0;
+
+int entry_add(uint64_t key, uint16_t move, uint32_t weight){
+	if(entrycount == entrycapacity){
+		uint64_t capacity = entrycapacity ? entrycapacity * 2 : 1 << 16;
+		bookentry_t* grown = (bookentry_t*)realloc(entries, capacity * sizeof(bookentry_t));
+		if(!grown){
+			printf("Failed to allocate memory\n");
+			return 0;
+		}
+		entries = grown;
+		entrycapacity = capacity;
+	}
+	entries[entrycount].key = key;
+	entries[entrycount].move = move;
+	entries[entrycount].weight = weight;
+	entrycount++;
+	return 1;
+}
+
+int main(int argc, char** argv){
+	int plies = 20;
+	int first = 1;
+	if(argc > 2 && !strcmp(argv[1], "-p")){
+		plies = atoi(argv[2]);
+		first = 3;
+	}
+	if(plies < 1 || first + 1 >= argc){
+		printf("usage: bookmake [-p plies] book.bin file.pgn...\n");
+		return -1;
+	}
+	const char* output = argv[first];
+
+	attacks_init();
+	if(!book_check()){
+		return -1;
+	}
+	position_t* pos = (position_t*)malloc(sizeof(position_t));
+	move_t* moves = (move_t*)malloc(plies * sizeof(move_t));
+	if(!pos || !moves){
+		printf("Failed to allocate memory\n");
+		return -1;
+	}
+
+	unsigned long long games = 0;
+	for(int f = first + 1; f < argc; f++){
+		int fd = open(argv[f], O_RDONLY);
+		if(fd < 0){
+			printf("Failed to open %s\n", argv[f]);
+			return -1;
+		}
+		struct stat info;
+		fstat(fd, &info);
+		if(!info.st_size){
+			close(fd);
+			continue;
+		}
+		const char* text = (const char*)mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(text == MAP_FAILED){
+			printf("Failed to map %s\n", argv[f]);
+			return -1;
+		}
+		madvise((void*)text, info.st_size, MADV_SEQUENTIAL);
+
+		pgnreader_t reader;
+		pgnreader_init(&reader, text, text + info.st_size);
+		reader.moves = moves;
+		reader.maxmoves = plies;
+		int result;
+		while((result = pgn_nextgame(&reader, pos)) != PGN_END){
+			if(result != PGN_OK || reader.fromfen){
+				continue;
+			}
+			games++;
+			//replay the opening again, this time hashing every position on the way
+			position_start(pos);
+			int count = reader.plies < plies ? reader.plies : plies;
+			for(int i = 0; i < count; i++){
+				int mover = pos -> turn;
+				uint32_t weight = 1;
+				if(reader.result == PGN_WHITEWIN || reader.result == PGN_BLACKWIN){
+					weight = (reader.result == PGN_WHITEWIN) == (mover == WHITE) ? 2 : 0;
+				}
+				if(!entry_add(book_key(pos), book_encode(moves[i]), weight)){
+					return -1;
+				}
+				position_makemove(pos, moves[i]);
+			}
+		}
+		munmap((void*)text, info.st_size);
+	}
+
+	//sort by key then move, and fold repeats of a move into one record
+	qsort(entries, entrycount, sizeof(bookentry_t), bookentry_compare);
+	FILE* file = fopen(output, "wb");
+	if(!file){
+		printf("Failed to write %s\n", output);
+		return -1;
+	}
+	uint64_t records = 0;
+	for(uint64_t i = 0; i < entrycount; ){
+		uint64_t j = i;
+		uint64_t weight = 0;
+		while(j < entrycount && entries[j].key == entries[i].key && entries[j].move == entries[i].move){
+			weight += entries[j].weight;
+			j++;
+		}
+		if(weight){
+			book_write(file, entries[i].key, entries[i].move, weight > 0xFFFF ? 0xFFFF : weight);
+			records++;
+		}
+		i = j;
+	}
+	fclose(file);
+	printf("games %llu positions %llu records %llu\n", games, (unsigned long long)entrycount, (unsigned long long)records);
+
+	free(entries);
+	free(moves);
+	free(pos);
+	return 0;
+}
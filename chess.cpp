@@ -7,88 +7,62 @@
 #include <math.h>
 #include <random>
 #include <time.h>
-
-const int PAWN = 0;
-const int BISHOP = 1;
-const int KNIGHT = 2;
-const int ROOK = 3;
-const int QUEEN = 4;
-const int KING = 5;
-
-const int BLACK = 0;
-const int WHITE = 1;
-
-typedef struct asset_s{
-	doge_image_t* image;
-	int width;
-	int height;
-} asset;
-
-typedef struct piece{
-	int type;
-	int color;
-	int cancastle;
-	int canpassant;
-} piece;
-
-piece* piece_make(int type, int color){
-	//allocate memory for new piece
-	piece* newpiece = (piece*)malloc(sizeof(piece));
-	if(!newpiece){
-		printf("Failed to allocate memory\n");
-		return nullptr;
-	}
-
-	//make a new piece
-	newpiece -> type = type;
-	newpiece -> color = color;
-	if(type == ROOK || type == KING){
-		newpiece -> cancastle = 1;
+#include <string.h>
+#include <stdlib.h>
+#include "bitboard.h"
+#include "search.h"
+#include "engine.h"
+#include "pgn.h"
+#include "uci.h"
+#include "layer.h"
+#include "sprite.h"
+#include "assets.h"
+
+//every picture on the board lives in one atlas and goes through one batch, so redrawing the board
+//is a single draw call
+atlas_t atlas;
+spritebatch_t batch;
+
+//the pieces load in the background while the board is already up, squares are drawn again as
+//their pieces arrive
+assets_t assets;
+int piecevisual[6][2];
+int visualsarrived = 0;
+int visualsfailed = 0;
+
+void visualready(int handle, int state, void* user){
+	(void)handle;
+	(void)user;
+	if(state == ASSET_READY){
+		visualsarrived = 1;
 	} else{
-		newpiece -> cancastle = 0;
+		visualsfailed = 1;
 	}
-	newpiece -> canpassant = 0;
-	return newpiece;
-}
-
-void piece_free(piece* piece){
-	free(piece);
-}
-
-asset* asset_load(const char* filename){
-	//load image
-	doge_image_t* image;
-	image = doge_image_load(filename);
-	if(!image){
-		printf("Failed loading img\n");
-		return nullptr;
-	}
-
-	//get memory for new asset
-	asset* newasset;
-	newasset = (asset*)malloc(sizeof(asset));
-	if(!newasset){
-		doge_image_free(image);
-		printf("Failed to malloc\n");
-		return nullptr;
-	}
-	//make new asset
-	newasset -> image = image;
-	newasset -> width = doge_image_width(image);
-	newasset -> height = doge_image_height(image);
-
-	return newasset;
-}
-
-void asset_free(asset* asset){
-	doge_image_free(asset -> image);
-
-	free(asset);
 }
 
-asset* piecevisual[6][2];
-
-piece* board[8][8];
+//move hint, a white disc tinted when drawn
+sprite_t hintvisual;
+
+position_t board;
+
+//where the game started and every move since, for saving it
+position_t gamestart;
+move_t* gamemoves;
+int gamelength = 0;
+int gamecapacity = 0;
+
+//computer player, only set up when it plays a side. it thinks on its own thread, the
+//board is only ever changed here
+engine_t engine;
+int engineused = 0;
+int engineponder = 1;
+searchlimits_t enginelimits = {0, 1000, 0, 0};
+//job whose answer gets played, 0 when none is out
+uint32_t enginejob = 0;
+book_t enginebook;
+//while pondering, the reply the pondering job assumes
+int pondering = 0;
+move_t pondermove = MOVE_NONE;
 
 const int tile = 150;
 
@@ -96,257 +70,351 @@ const int tilehalf = tile / 2;
 
 const int circle = tile / 2.5;
 
-doge_image_t* piece_image(piece* piece){
-	return piecevisual[piece -> type][piece -> color] -> image;
+//nullptr until the piece's image has loaded
+const sprite_t* piece_image(int type, int color){
+	return assets_sprite(&assets, piecevisual[type][color]);
 }
 
-int pawncanmove(int color, int x1, int y1, int x2, int y2){
-	//if moving one tile in y
-	if((color == WHITE && y2 == y1 + 1) || (color == BLACK && y2 == y1 - 1)){
-		//if x is same and no piece blocking
-		if(!board[x2][y2] && x1 == x2){
-			return 1;
-		} else
-		//if taking piece diagonally
-		if(board[x2][y2] && (x2 == x1 + 1 || x2 == x1 - 1)){
-			return 1;
-		}
-	} else
-	//moving 2 from starting
-	if((y1 == 1 && y2 == 3 && color == WHITE) || (y1 == 6 && y2 == 4 && color == BLACK)){
-		if(!board[x2][y2] && x2 == x1 && !board[x2][y1 + (y2 - y1) / 2]){
-			return 1;
+//look for a generated move from (x1, y1) to (x2, y2), promotion picks which pawn upgrade to match
+int findmove(int x1, int y1, int x2, int y2, int promotion, move_t* found){
+	movelist_t list;
+	movegen_legal(&board, &list);
+	for(int i = 0; i < list.count; i++){
+		move_t move = list.moves[i];
+		if(move_from(move) == square(x1, y1) && move_to(move) == square(x2, y2)){
+			if(move_flag(move) != MOVE_PROMOTION || move_promotion(move) == promotion){
+				if(found){
+					*found = move;
+				}
+				return 1;
+			}
 		}
 	}
 	return 0;
 }
 
-int bishopcanmove(int x1, int y1, int x2, int y2){
-	//if not moving diagonally
-	if(abs(x2 - x1) != abs(y2 - y1)){
-		return 0;
-	}
-	int dx = 1;
-	int dy = 1;
-	if(x2 < x1){
-		dx = -1;
-	}
-	if(y2 < y1){
-		dy = -1;
-	}
-	//if piece obstructing path of diagonal
-	for(int i = 1; i < abs(x2 - x1); i++){
-		if(board[x1 + dx * i][y1 + dy * i]){
-			return 0;
+int canmove(int x1, int y1, int x2, int y2){
+	return findmove(x1, y1, x2, y2, QUEEN, nullptr);
+}
+
+//destinations of the selected piece, only worked out again when the selection or the board changes
+bitboard_t hints = 0;
+int hints_square = -1;
+uint64_t hints_key = 0;
+
+bitboard_t movehints(int x, int y){
+	int sq = square(x, y);
+	if(sq != hints_square || board.key != hints_key){
+		movelist_t list;
+		movegen_legal(&board, &list);
+		hints = 0;
+		for(int i = 0; i < list.count; i++){
+			if(move_from(list.moves[i]) == sq){
+				hints |= bit(move_to(list.moves[i]));
+			}
 		}
+		hints_square = sq;
+		hints_key = board.key;
 	}
-	return 1;
+	return hints;
 }
 
-int knightcanmove(int x1, int y1, int x2, int y2){
-	//if moving 2 tiles in a direction and 1 tile perpendicular
-	if((abs(x2 - x1) == 2 && abs(y2 - y1) == 1) || (abs(x2-x1) == 1 && abs(y2-y1) == 2)){
-		return 1;
+int upgradepawn(int x1, int y1, int y2){
+	if(position_pieceon(&board, square(x1, y1)) == PAWN){
+		if((board.turn == WHITE && y2 == 7) || (board.turn == BLACK && y2 == 0)){
+			return 1;
+		}
 	}
 	return 0;
 }
 
-int rookcanmove(int x1, int y1, int x2, int y2){
-	//if moving in more than one direction
-	if(x2 != x1 && y2 != y1){
-		return 0;
-	}
-	int dx = 0;
-	int dy = 1;
-	if(y2 == y1){
-		dy = 0;
+void drawupgrades(int color, int x, int y){
+	int x_tile = x * tile;
+	int y_tile = (7 - y) * tile;
+	spritebatch_draw(&batch, piece_image(QUEEN, color), x_tile, y_tile, tilehalf, tilehalf);
+	spritebatch_draw(&batch, piece_image(ROOK, color), x_tile + tilehalf, y_tile, tilehalf, tilehalf);
+	spritebatch_draw(&batch, piece_image(KNIGHT, color), x_tile, y_tile + tilehalf, tilehalf, tilehalf);
+	spritebatch_draw(&batch, piece_image(BISHOP, color), x_tile + tilehalf, y_tile + tilehalf, tilehalf, tilehalf);
+}
+
+//how a square looks: the piece shown on it plus one (0 for none), its color, whether it's a move
+//hint and whether it's the selected square. the board layer only redraws squares whose look changed
+const int LOOK_COLOR = 1 << 3;
+const int LOOK_HINT = 1 << 4;
+const int LOOK_SELECTED = 1 << 5;
+
+//queue one square as described by look at board coordinates x, y
+void drawtile(int x, int y, int look){
+	int tile_x = x * tile;
+	int tile_y = (7 - y) * tile;
+	if(look & LOOK_SELECTED){
+		spritebatch_setcolor(&batch, 1, 1, 0.85);
 	} else
-	if(y2 < y1){
-		dy = -1;
+	//alternate tile colors
+	if((x + y) % 2){
+		spritebatch_setcolor(&batch, 0.94, 0.85, 0.75);
+	} else {
+		spritebatch_setcolor(&batch, 0.73, 0.33, 0.28);
 	}
-	if(x2 > x1){
-		dx = 1;
-	} else
-	if(x2 < x1){
-		dx = -1;
+	spritebatch_fill(&batch, tile_x, tile_y, tile, tile);
+	if(look & 7){
+		spritebatch_setcolor(&batch, 1, 1, 1);
+		spritebatch_draw(&batch, piece_image((look & 7) - 1, (look & LOOK_COLOR) ? WHITE : BLACK), tile_x, tile_y, tile, tile);
 	}
-	//if piece obstructing path of rook
-	for(int i = 1; i < abs(x2-x1 + y2-y1); i++){
-		if(board[x1 + dx * i][y1 + dy * i]){
-			return 0;
-		}
+	if(look & LOOK_HINT){
+		spritebatch_setcolor_alpha(&batch, 0.3, 0.3, 0.3, 0.4);
+		spritebatch_draw(&batch, &hintvisual, tile_x + tile / 2 - circle / 2, tile_y + tile / 2 - circle / 2, circle, circle);
 	}
-	return 1;
 }
 
-int queencanmove(int x1, int y1, int x2, int y2){
-	if(x2 == x1 || y2 == y1){
-		return rookcanmove(x1, y1, x2, y2);
-	} else
-	if(abs(x2-x1) == abs(y2-y1)){
-		return bishopcanmove(x1, y1, x2, y2);
+//start loading the pieces and put the hint disc in the atlas, returns 0 on failure
+int loadvisuals(){
+	const char* files[6][2] = {
+		{"blackpawn.png", "whitepawn.png"},
+		{"blackbishop.png", "whitebishop.png"},
+		{"blackknight.png", "whiteknight.png"},
+		{"blackrook.png", "whiterook.png"},
+		{"blackqueen.png", "whitequeen.png"},
+		{"blackking.png", "whiteking.png"}
+	};
+	//twelve tiles fit in six columns of two rows
+	if(!atlas_create(&atlas, 1024, 512)){
+		return 0;
 	}
-	return 0;
-}
-
-int kingcanmove(int x1, int y1, int x2, int y2){
-	//move 1 tile any direction
-	if(abs(x2-x1) < 2 && abs(y2-y1) < 2){
-		return 1;
+	int threads = std::thread::hardware_concurrency();
+	if(!assets_create(&assets, &atlas, "assets.pak", 12, threads < 4 ? threads : 4)){
+		return 0;
 	}
-	return 0;
-}
-
-int pawncanpassant(piece* pawn, int x1, int y1, int x2, int y2){
-	int dy = -1;
-	if(abs(x2 - x1) == 1 && y2 != y1){
-		if(y2 - y1 == 1){
-			dy = 1;
-		} else
-		if(y2 - y1 != -1){
-			return 0;
-		}
-		if((pawn -> color == WHITE && dy != 1) || (pawn -> color == BLACK && dy != -1)){
-			return 0;
-		}
-		if(board[x2][y1] && board[x2][y1] -> canpassant){
-			return 1;
+	assets.ready = visualready;
+	for(int type = PAWN; type <= KING; type++){
+		for(int color = BLACK; color <= WHITE; color++){
+			piecevisual[type][color] = assets_load(&assets, files[type][color], tile, tile);
 		}
 	}
-	return 0;
-}
-
-int kingcancastle(piece* king, int x1, int y1, int x2, int y2){
-	if(king -> cancastle){
-		if(y1 == y2){
-			int x = 7;
-			int dx = 1;
-			if(x2 == 2){
-				x = 0;
-				dx = -1;
-			} else
-			if(x2 != 6){
-				return 0;
-			}
-			if(board[x][y1]){
-				if(board[x][y1] -> cancastle){
-					if(rookcanmove(x, y1, x2 + dx, y1)){
-						return 1;
-					}
-				}
-			}
+	//hint disc, as big as doge_fill_ellipse drew it, with a one pixel soft edge
+	image_t disc;
+	disc.width = circle;
+	disc.height = circle;
+	disc.pixels = (unsigned char*)malloc(circle * circle * 4);
+	if(!disc.pixels){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	for(int y = 0; y < circle; y++){
+		for(int x = 0; x < circle; x++){
+			float dx = x + 0.5f - circle / 2.0f;
+			float dy = y + 0.5f - circle / 2.0f;
+			float edge = circle / 2.0f - sqrtf(dx * dx + dy * dy) + 0.5f;
+			unsigned char* p = disc.pixels + (y * circle + x) * 4;
+			p[0] = p[1] = p[2] = 0xFF;
+			p[3] = edge <= 0 ? 0 : edge >= 1 ? 0xFF : (unsigned char)(edge * 0xFF);
 		}
 	}
-	return 0;
+	int ok = atlas_add(&atlas, &disc, circle, circle, &hintvisual);
+	image_free(&disc);
+	if(!ok){
+		return 0;
+	}
+	return spritebatch_create(&batch, &atlas, 256);
 }
 
-int canmove(piece* piece, int x1, int y1, int x2, int y2){
-	//can't move on piece of same color
-	if(board[x2][y2] && board[x2][y2] -> color == piece -> color){
-		return 0;
+//print how the game ended, returns 1 if it did
+int checkgameover(){
+	int status = position_status(&board);
+	if(status == GAME_CHECKMATE){
+		printf("Checkmate, %s wins\n", board.turn == WHITE ? "black" : "white");
 	} else
-	//pawn movement
-	if(piece -> type == PAWN){
-		if(pawncanmove(piece -> color, x1, y1, x2, y2)){
-			return 1;
-		} else{
-			return pawncanpassant(piece, x1, y1, x2, y2);
-		}
-	} else
-	if(piece -> type == BISHOP){
-		return bishopcanmove(x1, y1, x2, y2);
+	if(status == GAME_STALEMATE){
+		printf("Stalemate\n");
 	} else
-	if(piece -> type == KNIGHT){
-		return knightcanmove(x1, y1, x2, y2);
+	if(status == GAME_INSUFFICIENT){
+		printf("Draw by insufficient material\n");
 	} else
-	if(piece -> type == ROOK){
-		return rookcanmove(x1, y1, x2, y2);
+	if(status == GAME_REPETITION){
+		printf("Draw by repetition\n");
 	} else
-	if(piece -> type == QUEEN){
-		return queencanmove(x1, y1, x2, y2);
-	} else
-	if(piece -> type == KING){
-		if(kingcanmove(x1, y1, x2, y2)){
-			return 1;
-		} else{
-			return kingcancastle(piece, x1, y1, x2, y2);
-		}
+	if(status == GAME_FIFTY){
+		printf("Draw by the fifty move rule\n");
 	}
-	return 0;
-}
-
-void movepiece(int x1, int y1, int x2, int y2){
-	piece_free(board[x2][y2]);
-	board[x2][y2] = board[x1][y1];
-	board[x1][y1] = nullptr;
+	return status != GAME_ONGOING;
 }
 
-void castle(int x1, int y1, int x2){
-	int dx = -1;
-	if(x1 < x2){
-		x2 = 7;
-		dx = 1;
-	} else{
-		x2 = 0;
+//play a move on the board, returns 1 if it ended the game
+int playmove(move_t move){
+	//the board never takes moves back, so old undo records can go, leaving room
+	//for the engine's search and enough for repetitions since the last capture
+	if(board.ply >= MAX_HISTORY - MAX_PLY){
+		position_trimhistory(&board, 128);
+	}
+	//the engine guessed this move, let it keep the search it has going, otherwise drop it
+	if(pondering){
+		if(move == pondermove){
+			engine_ponderhit(&engine);
+		} else{
+			engine_stop(&engine);
+			enginejob = 0;
+		}
+		pondering = 0;
+	} else
+	//any other search still going is of a position this move leaves behind
+	if(enginejob){
+		engine_stop(&engine);
+		enginejob = 0;
 	}
-	movepiece(x2, y1, x1 + dx, y1);
+	if(gamelength == gamecapacity){
+		int capacity = gamecapacity ? gamecapacity * 2 : 256;
+		move_t* moves = (move_t*)realloc(gamemoves, capacity * sizeof(move_t));
+		if(moves){
+			gamemoves = moves;
+			gamecapacity = capacity;
+		}
+	}
+	if(gamelength < gamecapacity){
+		gamemoves[gamelength++] = move;
+	}
+	position_makemove(&board, move);
+	return checkgameover();
 }
 
-void checkmove(piece* selected, int selected_x, int selected_y, int destination_x, int destination_y){
-	//if king is castling
-	if(selected -> type == KING && abs(destination_x - selected_x) == 2){
-		//move rook
-		castle(selected_x, selected_y, destination_x);
-	}
-	//if moving a king or rook set cancastle false
-	if(selected -> type == KING || selected -> type == ROOK){
-		selected -> cancastle = 0;
+//start from the end of the first game in a PGN file, returns 0 if it can't be read or replayed
+int loadgame(const char* filename){
+	FILE* file = fopen(filename, "rb");
+	if(!file){
+		printf("Failed to open %s\n", filename);
+		return 0;
 	}
-	//if pawn moves 2, canpassant
-	if(selected -> type == PAWN && abs(destination_y - selected_y) == 2){
-		selected -> canpassant = 1;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* text = (char*)malloc(size > 0 ? size : 1);
+	if(!text){
+		fclose(file);
+		printf("Failed to allocate memory\n");
+		return 0;
 	}
-	//if performing en passant, take pawn
-	if(selected -> type == PAWN && selected_x != destination_x && !board[destination_x][destination_y]){
-		board[destination_x][selected_y] = nullptr;
+	size = fread(text, 1, size, file);
+	fclose(file);
+
+	pgnreader_t reader;
+	pgnreader_init(&reader, text, text + size);
+	int result = pgn_nextgame(&reader, &board);
+	free(text);
+	if(result != PGN_OK){
+		printf("Failed to replay %s\n", filename);
+		position_start(&board);
+		return 0;
 	}
+	return 1;
 }
 
-int upgradepawn(piece* piece, int y){
-	if(piece -> type == PAWN){
-		if((piece -> color == WHITE && y == 7) || (piece -> color == BLACK && y == 0)){
-			return 1;
-		}
+//write the game so far to save.pgn and the current position to save.fen
+void savegame(){
+	char fen[FEN_MAX];
+	position_tofen(&board, fen);
+	FILE* file = fopen("save.fen", "w");
+	if(!file){
+		printf("Failed to write save.fen\n");
+		return;
 	}
-	return 0;
+	fprintf(file, "%s\n", fen);
+	fclose(file);
+
+	const char* result = "*";
+	int status = position_status(&board);
+	if(status == GAME_CHECKMATE){
+		result = board.turn == WHITE ? "0-1" : "1-0";
+	} else
+	if(status != GAME_ONGOING){
+		result = "1/2-1/2";
+	}
+	file = fopen("save.pgn", "w");
+	if(!file){
+		printf("Failed to write save.pgn\n");
+		return;
+	}
+	pgn_write(file, &gamestart, gamemoves, gamelength, result);
+	fclose(file);
+	printf("Saved %s\n", fen);
 }
 
-void drawupgrades(int color, int x, int y){
-	int x_tile = x * tile;
-	int y_tile = (7 - y) * tile;
-	doge_draw_image(piecevisual[QUEEN][color] -> image, x_tile, y_tile, tilehalf, tilehalf);
-	doge_draw_image(piecevisual[ROOK][color] -> image, x_tile + tilehalf, y_tile, tilehalf, tilehalf);
-	doge_draw_image(piecevisual[KNIGHT][color] -> image, x_tile, y_tile + tilehalf, tilehalf, tilehalf);
-	doge_draw_image(piecevisual[BISHOP][color] -> image, x_tile + tilehalf, y_tile + tilehalf, tilehalf, tilehalf);
+//think on the opponent's time about the position after the reply the engine expects
+void startponder(move_t expected){
+	if(!engineponder || expected == MOVE_NONE){
+		return;
+	}
+	position_t guess = board;
+	position_makemove(&guess, expected);
+	if(position_status(&guess) != GAME_ONGOING){
+		return;
+	}
+	enginejob = engine_go(&engine, &guess, enginelimits, 1);
+	if(enginejob){
+		pondering = 1;
+		pondermove = expected;
+	}
 }
 
-void pawnupgrade(piece* piece, int x, int y, int mouse_x, int mouse_y){
+//piece type picked from the upgrade overlay under the mouse
+int pawnupgrade(int x, int y, int mouse_x, int mouse_y){
 	if(mouse_x < (x * tile + tilehalf)){
 		if(mouse_y < (7 - y) * tile + tilehalf){
-			piece -> type = QUEEN;
+			return QUEEN;
 		} else{
-			piece -> type = KNIGHT;
+			return KNIGHT;
 		}
 	} else{
 		if(mouse_y < (7 - y) * tile + tilehalf){
-			piece -> type = ROOK;
+			return ROOK;
 		} else{
-			piece -> type = BISHOP;
+			return BISHOP;
 		}
 	}
 }
 
-int main(){
+int main(int argc, char** argv){
+	//--uci runs the engine on stdin and stdout, before anything opens a window
+	if(argc > 1 && !strcmp(argv[1], "--uci")){
+		return uci_loop();
+	}
+
+	//-e white|black|both lets the engine play a side, -m sets its time per move in ms, -d caps its depth,
+	//-t sets how many threads it searches with, -p off stops it thinking on the opponent's time.
+	//-f starts from a FEN position, -g from the end of the first game in a PGN file, -b gives the
+	//engine an opening book to play from before it searches
+	int engineplays[2] = {0, 0};
+	int enginethreads = 1;
+	const char* startfen = nullptr;
+	const char* startpgn = nullptr;
+	const char* bookfile = nullptr;
+	for(int i = 1; i + 1 < argc; i += 2){
+		if(!strcmp(argv[i], "-e")){
+			engineplays[WHITE] = !strcmp(argv[i + 1], "white") || !strcmp(argv[i + 1], "both");
+			engineplays[BLACK] = !strcmp(argv[i + 1], "black") || !strcmp(argv[i + 1], "both");
+		} else
+		if(!strcmp(argv[i], "-m")){
+			enginelimits.movetime = atoi(argv[i + 1]);
+		} else
+		if(!strcmp(argv[i], "-d")){
+			enginelimits.depth = atoi(argv[i + 1]);
+			enginelimits.movetime = 0;
+		} else
+		if(!strcmp(argv[i], "-t")){
+			enginethreads = atoi(argv[i + 1]);
+		} else
+		if(!strcmp(argv[i], "-p")){
+			engineponder = strcmp(argv[i + 1], "off") != 0;
+		} else
+		if(!strcmp(argv[i], "-f")){
+			startfen = argv[i + 1];
+		} else
+		if(!strcmp(argv[i], "-g")){
+			startpgn = argv[i + 1];
+		} else
+		if(!strcmp(argv[i], "-b")){
+			bookfile = argv[i + 1];
+		}
+	}
+
     int error;
 
     error = glfwInit();
@@ -378,70 +446,41 @@ int main(){
         return -1;
     }
 
-	//white assets
-	asset* wpawn = asset_load("whitepawn.png");
-	asset* wbishop = asset_load("whitebishop.png");
-	asset* wknight = asset_load("whiteknight.png");
-	asset* wrook = asset_load("whiterook.png");
-	asset* wqueen = asset_load("whitequeen.png");
-	asset* wking = asset_load("whiteking.png");
-	//black assets
-	asset* bpawn = asset_load("blackpawn.png");
-	asset* bbishop = asset_load("blackbishop.png");
-	asset* bknight = asset_load("blackknight.png");
-	asset* brook = asset_load("blackrook.png");
-	asset* bqueen = asset_load("blackqueen.png");
-	asset* bking = asset_load("blackking.png");
 	//if assets fail, return error
-	if(!(wpawn && wbishop && wknight && wrook && wqueen && wking
-	  && bpawn && bbishop && bknight && brook && bqueen && bking)){
+	if(!loadvisuals()){
 		printf("Failed to load asset\n");
 		return -1;
 	}
 
-	//white pieces
-	piecevisual[PAWN][BLACK] = bpawn;
-	piecevisual[BISHOP][BLACK] = bbishop;
-	piecevisual[KNIGHT][BLACK] = bknight;
-	piecevisual[ROOK][BLACK] = brook;
-	piecevisual[QUEEN][BLACK] = bqueen;
-	piecevisual[KING][BLACK] = bking;
-	//black pieces
-	piecevisual[PAWN][WHITE] = wpawn;
-	piecevisual[BISHOP][WHITE] = wbishop;
-	piecevisual[KNIGHT][WHITE] = wknight;
-	piecevisual[ROOK][WHITE] = wrook;
-	piecevisual[QUEEN][WHITE] = wqueen;
-	piecevisual[KING][WHITE] = wking;
-
 	//initialize board
-	int piececol = WHITE;
-	for(int y = 0; y < 8; y++){
-		if(y > 4){
-			piececol = BLACK;
-		}
-		//draw piece row
-		if(y == 0 || y == 7){
-			board[0][y] = piece_make(ROOK, piececol);
-			board[1][y] = piece_make(KNIGHT, piececol);
-			board[2][y] = piece_make(BISHOP, piececol);
-			board[3][y] = piece_make(QUEEN, piececol);
-			board[4][y] = piece_make(KING, piececol);
-			board[5][y] = piece_make(BISHOP, piececol);
-			board[6][y] = piece_make(KNIGHT, piececol);
-			board[7][y] = piece_make(ROOK, piececol);
-		} else
-		//draw pawn row
-		if(y == 1 || y == 6){
-			for(int x = 0; x < 8; x++){
-				board[x][y] = piece_make(PAWN, piececol);
-			}
-		} else{
-			//create nullptr in empty spots
-			for(int x = 0; x < 8; x++){
-				board[x][y] = nullptr;
-			}
+	attacks_init();
+	position_start(&board);
+	if(startfen && !position_fromfen(&board, startfen)){
+		printf("Failed to parse fen\n");
+		return -1;
+	}
+	if(startpgn && !loadgame(startpgn)){
+		return -1;
+	}
+	gamestart = board;
+	gamestart.ply = 0;
+	engineused = engineplays[WHITE] || engineplays[BLACK];
+	//pondering only makes sense against a player who takes their time
+	if(engineplays[WHITE] && engineplays[BLACK]){
+		engineponder = 0;
+	}
+	if(engineused && !engine_create(&engine, enginethreads, 64)){
+		return -1;
+	}
+	//endgame bitbases are optional, bitbasegen writes them
+	if(engineused){
+		bitbase_load("bitbases.bin");
+	}
+	if(engineused && bookfile){
+		if(!book_open(&enginebook, bookfile)){
+			return -1;
 		}
+		engine.book = &enginebook;
 	}
 
 	//mass declaration of variables
@@ -449,7 +488,7 @@ int main(){
 	int mouse_x_tile = 0;
 	int mouse_y_tile = 0;
 
-	piece* selected = nullptr;
+	int selected = 0;
 	int selected_x = 0;
 	int selected_y = 0;
 
@@ -461,15 +500,34 @@ int main(){
 
 	int firstclick = 0;
 
-	int turn = WHITE;
+	int gameover = checkgameover();
+
+	//s saves the game, once per press
+	int save_pressed = 0;
+
+	move_t move;
 
 	int upgrading = 0;
 	int upgrading_x = -1;
 	int upgrading_y = -1;
+	int upgrading_from_x = -1;
+	int upgrading_from_y = -1;
+
+	//the board is kept drawn in a layer and only the squares that change are drawn again. if
+	//the driver can't render to a texture every square is drawn straight to the window each frame
+	layer_t boardlayer;
+	int layered = layer_create(&boardlayer, 8 * tile, 8 * tile);
+	int looks[64];
+	for(int sq = 0; sq < 64; sq++){
+		looks[sq] = -1;
+	}
+	//what the last frame on screen showed, nothing new means no frame is drawn
+	int drawn_mouse_x = -1;
+	int drawn_mouse_y = -1;
+	int drawn_upgrading = 0;
+	double drawn_time = 0;
 
     while(!doge_window_shouldclose(window)){
-        /* clear the window */
-        doge_clear();
 
 		//set mouse_x and mouse_y to mouse's x and y position relative to window's 0,0
 		doge_window_getcursorpos(window, &mouse_x, &mouse_y);
@@ -490,70 +548,68 @@ int main(){
 					release_x = mouse_x_tile;
 					release_y = mouse_y_tile;
 				}
+				int click_sq = square(click_x, click_y);
 				if(!upgrading){
 					//if not selecting a piece
 					if(!selected){
 						//if clicking on allied piece
-						if(!mouse_clicked && board[click_x][click_y] && board[click_x][click_y] -> color == turn){
+						if(!mouse_clicked && !gameover && !engineplays[board.turn] && position_pieceon(&board, click_sq) != EMPTY && position_coloron(&board, click_sq) == board.turn){
 							//select piece that is left clicked
 							selected_x = click_x;
 							selected_y = click_y;
-							selected = board[selected_x][selected_y];
+							selected = 1;
 						}
 					} else{
 						//if piece selected and clicking
 						if(!mouse_clicked){
 							//if clicking allied piece while piece selected
-							if(board[click_x][click_y] && board[click_x][click_y] != selected && board[click_x][click_y] -> color == turn){
+							if(!engineplays[board.turn] && position_pieceon(&board, click_sq) != EMPTY && (click_x != selected_x || click_y != selected_y) && position_coloron(&board, click_sq) == board.turn){
 								//select piece
 								selected_x = click_x;
 								selected_y = click_y;
-								selected = board[selected_x][selected_y];
 							} else
 							//if moving piece via click
-							if(canmove(selected, selected_x, selected_y, click_x, click_y)){
-								//check if piece statuses changing
-								checkmove(selected, selected_x, selected_y, click_x, click_y);
-								//"take" any pieces at destination
-								movepiece(selected_x, selected_y, click_x, click_y);
-								//check if pawn should be upgraded
-								if(upgradepawn(selected, click_y)){
+							if(canmove(selected_x, selected_y, click_x, click_y)){
+								//check if pawn should be upgraded before moving
+								if(upgradepawn(selected_x, selected_y, click_y)){
 									upgrading = 1;
 									upgrading_x = click_x;
 									upgrading_y = click_y;
+									upgrading_from_x = selected_x;
+									upgrading_from_y = selected_y;
 								} else{
-									//change turns
-									turn = !turn;
+									//move piece and change turns
+									findmove(selected_x, selected_y, click_x, click_y, QUEEN, &move);
+									gameover = playmove(move);
 								}
 								//deselect piece
-								selected = nullptr;
+								selected = 0;
 
 							} else
 							//if clicking on selected piece
 							if(click_x == selected_x && click_y == selected_y){
 								//deselect
 								if(firstclick){
-									selected = nullptr;
+									selected = 0;
 								}
 							}
 						} else
 						//if moving piece via click and drag
-						if(canmove(selected, selected_x, selected_y, release_x, release_y)){
-							//check if piece statuses changing
-							checkmove(selected, selected_x, selected_y, release_x, release_y);
-							//if mouse on another piece's tile, take piece
-							movepiece(selected_x, selected_y, release_x, release_y);
-							//check if pawn should be upgraded
-								if(upgradepawn(selected, release_y)){
-									upgrading = 1;
-									upgrading_x = release_x;
-									upgrading_y = release_y;
-								} else{
-									//change turns
-									turn = !turn;
-								}
-								//deselect piece
-								selected = nullptr;
+						if(canmove(selected_x, selected_y, release_x, release_y)){
+							//check if pawn should be upgraded before moving
+							if(upgradepawn(selected_x, selected_y, release_y)){
+								upgrading = 1;
+								upgrading_x = release_x;
+								upgrading_y = release_y;
+								upgrading_from_x = selected_x;
+								upgrading_from_y = selected_y;
+							} else{
+								//move piece and change turns
+								findmove(selected_x, selected_y, release_x, release_y, QUEEN, &move);
+								gameover = playmove(move);
+							}
+							//deselect piece
+							selected = 0;
 						} else
 						if(!firstclick){
 							firstclick = 1;
@@ -561,94 +617,142 @@ int main(){
 					}
 				} else{
 					if(!mouse_clicked && mouse_x_tile == upgrading_x && mouse_y_tile == upgrading_y){
-						pawnupgrade(board[upgrading_x][upgrading_y], upgrading_x, upgrading_y, mouse_x, mouse_y);
+						int type = pawnupgrade(upgrading_x, upgrading_y, mouse_x, mouse_y);
+						findmove(upgrading_from_x, upgrading_from_y, upgrading_x, upgrading_y, type, &move);
+						gameover = playmove(move);
 						upgrading = 0;
-						turn = !turn;
 						upgrading_x = -1;
 						upgrading_y = -1;
+						upgrading_from_x = -1;
+						upgrading_from_y = -1;
 					}
 				}
 				mouse_clicked = doge_window_mousepressed(window, DOGE_MOUSE_BUTTON_LEFT);
 			}
 		} else
 		if(mouse_clicked && !doge_window_mousepressed(window, DOGE_MOUSE_BUTTON_LEFT)){
-			selected = nullptr;
+			selected = 0;
 			selected_x = -1;
 			selected_y = -1;
 		}
-		//draws chess board
-		for(int y = 0; y < 8; y++){
-			for(int x = 0; x < 8; x++){
-				//alternate tile colors
-				if((x + y) % 2){
-					doge_setcolor(0.94, 0.85, 0.75);
-				} else {
-					doge_setcolor(0.73, 0.33, 0.28);
-				}
-				//draw tiles
-				doge_fill_rectangle(x * tile, y * tile, tile, tile);
-
-				//draw pieces on board by location
-				doge_setcolor(1, 1, 1);
-				if(board[x][7 - y] && (x != upgrading_x || 7 - y != upgrading_y)){
-					doge_draw_image(piece_image(board[x][7-y]), x * tile, y * tile, tile, tile);
-					if(board[x][7-y] -> canpassant == 1){
-						if(board[x][7-y] -> color == turn){
-							board[x][7-y] -> canpassant = 0;
-						}
-					}
-				}
-				if(upgrading){
-					doge_setcolor_alpha(1, 1, 1, 0.02);
-					doge_draw_image(piece_image(board[upgrading_x][upgrading_y]), upgrading_x * tile, (7 - upgrading_y) * tile, tile, tile);
-					doge_setcolor(1, 1, 1);
-					drawupgrades(board[upgrading_x][upgrading_y] -> color, upgrading_x, upgrading_y);
-				}
+		//pieces that finished loading go into the atlas, the squares showing them are drawn again
+		int loading = assets_poll(&assets);
+		if(visualsfailed){
+			printf("Failed to load asset\n");
+			return -1;
+		}
+		if(visualsarrived){
+			visualsarrived = 0;
+			for(int sq = 0; sq < 64; sq++){
+				looks[sq] = -1;
 			}
 		}
-		doge_setcolor_alpha(0.3, 0.3, 0.3, 0.4);
-		for(int x = 0; x < 8; x++){
-			for(int y = 0; y < 8; y++){
-				if(selected && canmove(selected, selected_x, selected_y, x, y)){
-					doge_fill_ellipse(x * tile + tile / 2 - circle / 2, (7 - y) * tile + tile / 2 - circle / 2, circle, circle);
-				}
+
+		//work out how every square should look and bring the board layer up to date
+		bitboard_t targets = selected ? movehints(selected_x, selected_y) : 0;
+		int dragging = selected && mouse_clicked;
+		int changed = 0;
+		if(layered){
+			layer_begin(&boardlayer);
+		}
+		for(int sq = 0; sq < 64; sq++){
+			int x = square_x(sq);
+			int y = square_y(sq);
+			int look = 0;
+			int type = position_pieceon(&board, sq);
+			//hide the pawn being upgraded and whatever it takes, and a piece being dragged
+			int hidden = (x == upgrading_x && y == upgrading_y) || (x == upgrading_from_x && y == upgrading_from_y);
+			int picked = selected && x == selected_x && y == selected_y;
+			if(type != EMPTY && !hidden && !(picked && dragging)){
+				look = (type + 1) | (position_coloron(&board, sq) == WHITE ? LOOK_COLOR : 0);
+			}
+			if(targets & bit(sq)){
+				look |= LOOK_HINT;
+			}
+			if(picked){
+				look |= LOOK_SELECTED;
+			}
+			if(look != looks[sq] || !layered){
+				drawtile(x, y, look);
+				looks[sq] = look;
+				changed++;
 			}
 		}
+		spritebatch_flush(&batch);
+		if(layered){
+			layer_end(&boardlayer);
+		}
 
-		//if mouse held down and piece selected
-		if(selected){
-			//set color to tile behind selected piece
-			if((selected_x + selected_y) % 2){
-				doge_setcolor(1, 1, 0.85);
-			} else {
-				doge_setcolor(1, 1, 0.85);
+		//a frame is only drawn when something on it moved, and now and then in case the window was covered
+		double now = glfwGetTime();
+		if(changed || upgrading != drawn_upgrading || (dragging && (mouse_x != drawn_mouse_x || mouse_y != drawn_mouse_y)) || now - drawn_time > 0.5){
+			if(layered){
+				/* clear the window */
+				doge_clear();
+				layer_draw(&boardlayer, 0, 0);
 			}
-			//redraw tile over selected piece
-			doge_fill_rectangle(selected_x * tile, (7 - selected_y) * tile, tile, tile);
-			doge_setcolor(1, 1, 1);
 			//draw selected piece at cursor to give illusion of holding piece
-			if(mouse_clicked){
-				doge_draw_image(piece_image(selected), mouse_x - tile / 2, mouse_y - tile / 2, tile, tile);
-			} else{
-				doge_draw_image(piece_image(selected), selected_x * tile, (7 - selected_y) * tile, tile, tile);
+			if(dragging){
+				spritebatch_setcolor(&batch, 1, 1, 1);
+				spritebatch_draw(&batch, piece_image(position_pieceon(&board, square(selected_x, selected_y)), board.turn), mouse_x - tile / 2, mouse_y - tile / 2, tile, tile);
+			}
+			//promotion choices over the square the pawn is going to
+			if(upgrading){
+				spritebatch_setcolor_alpha(&batch, 1, 1, 1, 0.02);
+				spritebatch_draw(&batch, piece_image(PAWN, board.turn), upgrading_x * tile, (7 - upgrading_y) * tile, tile, tile);
+				spritebatch_setcolor(&batch, 1, 1, 1);
+				drawupgrades(board.turn, upgrading_x, upgrading_y);
 			}
+			spritebatch_flush(&batch);
+			/* swap the frame buffer */
+			doge_window_render(window);
+			drawn_mouse_x = mouse_x;
+			drawn_mouse_y = mouse_y;
+			drawn_upgrading = upgrading;
+			drawn_time = now;
+		} else{
+			//nothing to show, sleep until there's input or it's time to check on the engine
+			glfwWaitEventsTimeout(enginejob || loading ? 0.005 : 0.05);
 		}
-        /* swap the frame buffer */
-        doge_window_render(window);
 
         /* check for keyboard, mouse, or close event */
         doge_window_poll();
-    }
-	//loop through board to free all pieces
-	for(int x = 0; x < 8; x++){
-		for(int y = 0; y < 8; y++){
-			free(board[x][y]);
+
+		if(doge_window_keypressed(window, DOGE_KEY_S) != save_pressed){
+			save_pressed = !save_pressed;
+			if(save_pressed){
+				savegame();
+			}
 		}
-	}
+
+		//the engine never holds up a frame, its answer is picked up whenever it's ready
+		if(engineused && !gameover){
+			move_t expected;
+			if(enginejob && !pondering && engine_takemove(&engine, enginejob, &move, &expected)){
+				enginejob = 0;
+				gameover = playmove(move);
+				selected = 0;
+				if(!gameover && !engineplays[board.turn]){
+					startponder(expected);
+				}
+			}
+			//engine_go turns the job down while a cancelled one winds down, so it's asked again next frame
+			if(!gameover && !upgrading && !enginejob && engineplays[board.turn]){
+				enginejob = engine_go(&engine, &board, enginelimits, 0);
+			}
+		}
+    }
 	//free all assets
-	for(int type = PAWN; type <= KING; type++){
-		asset_free(piecevisual[type][0]);
-		asset_free(piecevisual[type][1]);
+	spritebatch_free(&batch);
+	assets_free(&assets);
+	atlas_free(&atlas);
+	if(engineused){
+		engine_free(&engine);
+	}
+	book_close(&enginebook);
+	free(gamemoves);
+	if(layered){
+		layer_free(&boardlayer);
 	}
 	//free doge_window
 	doge_window_free(window);
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "entities.h"
+#include "grid.h"
+#include "nanotime.h"
+
+//projectile against alien collision with every pair tried and through the grid, on n projectiles
+//and n aliens for n = 1000, 2000, 5000, 10000, ... up to the most asked for
+//usage: collidebench [max n] [cell size]    defaults 10000 and 128
+//entities are the game's sizes scattered over a square field that grows with n, so the
+//fraction of the field covered by aliens stays the same and only the count changes. before
+//timing, both ways have to agree on which projectiles touch an alien; the hits themselves can
+//differ by a few where a projectile overlaps more than one alien and each way pairs it with another
+
+//the same generator everywhere, so both ways see the same field
+unsigned int benchrandom(unsigned long* state){
+	*state = *state * 6364136223846793005UL + 1442695040888963407UL;
+	return (unsigned int)(*state >> 33);
+}
+
+void scatter(entities_t* entities, int n, int width, int height, int field, unsigned long* state){
+	entities -> count = 0;
+	for(int i = 0; i < n; i++){
+		entities_add(entities, 0, benchrandom(state) % (field - width), benchrandom(state) % (field - height), width, height);
+	}
+}
+
+//the way the game did it before the grid: every projectile against every alien still there
+int collide_pairs(entities_t* projectiles, entities_t* aliens){
+	int hits = 0;
+	for(int i = 0; i < projectiles -> count; ){
+		int hit = 0;
+		for(int x = 0; x < aliens -> count; x++){
+			if(collides(projectiles, i, aliens, x)){
+				entities_remove(aliens, x);
+				entities_remove(projectiles, i);
+				hit = 1;
+				hits++;
+				break;
+			}
+		}
+		if(!hit){
+			i++;
+		}
+	}
+	return hits;
+}
+
+//projectiles with a corner in some alien, which unlike the hits doesn't depend on which of
+//several overlapping aliens a projectile gets paired with, tried on every pair
+int touching_pairs(const entities_t* projectiles, const entities_t* aliens){
+	int touching = 0;
+	for(int i = 0; i < projectiles -> count; i++){
+		for(int x = 0; x < aliens -> count; x++){
+			if(collides(projectiles, i, aliens, x)){
+				touching++;
+				break;
+			}
+		}
+	}
+	return touching;
+}
+
+//and the same through the grid, with nothing marked hit
+int touching_grid(grid_t* grid, const entities_t* projectiles, const entities_t* aliens){
+	if(!grid_build(grid, aliens) || !grid_reserve((void**)&grid -> alienhit, &grid -> aliencapacity, aliens -> count, 1)){
+		return -1;
+	}
+	memset(grid -> alienhit, 0, aliens -> count);
+	int touching = 0;
+	for(int i = 0; i < projectiles -> count; i++){
+		touching += grid_find(grid, projectiles, i) >= 0;
+	}
+	return touching;
+}
+
+int main(int argc, char** argv){
+	int maxn = argc > 1 ? atoi(argv[1]) : 10000;
+	int cellsize = argc > 2 ? atoi(argv[2]) : 128;
+	if(maxn < 1 || cellsize < 1){
+		printf("usage: collidebench [max n] [cell size]\n");
+		return -1;
+	}
+
+	entities_t projectiles;
+	entities_t aliens;
+	if(!entities_create(&projectiles, maxn) || !entities_create(&aliens, maxn)){
+		return -1;
+	}
+
+	const int steps[3] = {1, 2, 5};
+	for(int scale = 1000; ; scale *= 10){
+		for(int s = 0; s < 3; s++){
+			int n = scale * steps[s];
+			if(n > maxn){
+				entities_free(&projectiles);
+				entities_free(&aliens);
+				return 0;
+			}
+			//aliens cover about a tenth of the field
+			int field = 1;
+			while((long)field * field < (long)n * 100 * 100 * 10){
+				field++;
+			}
+
+			grid_t grid;
+			if(!grid_create(&grid, field, field, cellsize)){
+				return -1;
+			}
+			unsigned long state = n;
+			scatter(&projectiles, n, 20, 100, field, &state);
+			scatter(&aliens, n, 100, 100, field, &state);
+			if(touching_pairs(&projectiles, &aliens) != touching_grid(&grid, &projectiles, &aliens)){
+				printf("n %d grid and pairs disagree\n", n);
+				return -1;
+			}
+			unsigned long start = nanotime();
+			int pairhits = collide_pairs(&projectiles, &aliens);
+			unsigned long pairtime = nanotime() - start;
+
+			//a first run sizes the grid's arrays, the game rebuilds every tick into the same ones
+			state = n;
+			scatter(&projectiles, n, 20, 100, field, &state);
+			scatter(&aliens, n, 100, 100, field, &state);
+			grid_collide(&grid, &projectiles, &aliens);
+			state = n;
+			scatter(&projectiles, n, 20, 100, field, &state);
+			scatter(&aliens, n, 100, 100, field, &state);
+			start = nanotime();
+			int gridhits = grid_collide(&grid, &projectiles, &aliens);
+			unsigned long gridtime = nanotime() - start;
+			grid_free(&grid);
+
+			printf("n %d field %d pairs %.3fms hits %d grid %.3fms hits %d speedup %.1f\n", n, field,
+			       pairtime / 1e6, pairhits, gridtime / 1e6, gridhits, (double)pairtime / (gridtime ? gridtime : 1));
+		}
+	}
+}
@@ -0,0 +1,229 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "bitboard.h"
+#include "tt.h"
+#include "search.h"
+#include "book.h"
+
+//the engine on a thread of its own, so whoever drives it (a window, a protocol loop) never waits
+//on a search
+//
+//the caller hands over a job with engine_go while the worker is idle and later picks the answer
+//out of a one slot mailbox with engine_takemove. the job and answer never go through a lock: the
+//job is only written while the worker sleeps, the answer is a single 64 bit word. the worker sleeps
+//on a condition variable while idle or holding a ponder answer, and every call that gives it
+//something to do wakes it
+//
+//a job can ponder, searching the position after the reply the engine expects while the opponent
+//thinks. if they play it, engine_ponderhit starts the clock and the search carries on where it
+//is, anything else gets engine_stop and a fresh job
+//
+//a job with an infinite limit searches like a ponder one, holding its answer until engine_finish,
+//but without waiting on a ponderhit to start a clock
+//
+//with a book set, positions found in it are answered from the book without searching
+
+const int ENGINE_IDLE = 0;
+const int ENGINE_BUSY = 1;
+
+struct engine_s{
+	std::thread worker;
+	searcher_t* searchers;
+	int threads;
+	tt_t hash;
+	searchshared_t shared;
+	//opening book, nullptr for none, and the state of the generator picking its moves
+	const book_t* book;
+	uint64_t bookrandom;
+
+	//the job, only touched by the caller while the worker is idle
+	position_t pos;
+	searchlimits_t limits;
+	uint32_t job;
+
+	std::atomic<int> state;
+	//set by engine_stop, the answer to a cancelled job is never posted
+	std::atomic<int> cancel;
+	//set by engine_finish, lets an infinite job post its answer
+	std::atomic<int> finished;
+	std::atomic<int> quit;
+	//job id in the high 32 bits, expected reply in the next 16, move in the low 16, 0 when empty
+	std::atomic<uint64_t> mailbox;
+	//the worker waits on wake, the lock is only taken to sleep and to wake it
+	std::mutex lock;
+	std::condition_variable wake;
+	//called on the worker each time a job ends, after its answer is posted, nullptr for none
+	void (*done)(void* user);
+	void* user;
+};
+
+typedef struct engine_s engine_t;
+
+//wake the worker after changing what it waits on. taking the lock orders the change before the
+//worker's next look at it, so it either sees it or is already asleep and gets woken
+inline void engine_wake(engine_t* engine){
+	{
+		std::lock_guard<std::mutex> guard(engine -> lock);
+	}
+	engine -> wake.notify_all();
+}
+
+inline void engine_worker(engine_t* engine){
+	while(!engine -> quit.load(std::memory_order_acquire)){
+		if(engine -> state.load(std::memory_order_acquire) != ENGINE_BUSY){
+			std::unique_lock<std::mutex> guard(engine -> lock);
+			engine -> wake.wait(guard, [engine]{
+				return engine -> quit.load(std::memory_order_acquire) || engine -> state.load(std::memory_order_acquire) == ENGINE_BUSY;
+			});
+			continue;
+		}
+		move_t ponder = MOVE_NONE;
+		move_t move = MOVE_NONE;
+		//pondering or analysing a book position would just be waiting, so those search like any other
+		if(engine -> book && !engine -> limits.infinite && !engine -> shared.ponder.load(std::memory_order_acquire)){
+			move = book_probe(engine -> book, &engine -> pos, &engine -> bookrandom);
+		}
+		if(move == MOVE_NONE){
+			move = search_parallel(engine -> searchers, engine -> threads, &engine -> pos, &engine -> shared, engine -> limits, &ponder);
+		}
+		//a ponder search that ends on its own holds its answer until the opponent moves, an infinite
+		//one until it's stopped
+		{
+			std::unique_lock<std::mutex> guard(engine -> lock);
+			engine -> wake.wait(guard, [engine]{
+				return (!engine -> shared.ponder.load(std::memory_order_acquire) &&
+				        (!engine -> limits.infinite || engine -> finished.load(std::memory_order_acquire))) ||
+				       engine -> cancel.load(std::memory_order_acquire);
+			});
+		}
+		if(!engine -> cancel.load(std::memory_order_acquire)){
+			engine -> mailbox.store((uint64_t)engine -> job << 32 | (uint64_t)ponder << 16 | move, std::memory_order_release);
+		}
+		engine -> state.store(ENGINE_IDLE, std::memory_order_release);
+		if(engine -> done){
+			engine -> done(engine -> user);
+		}
+	}
+}
+
+//start the worker with threads search threads and a hash_mb table, returns 0 on failure
+inline int engine_create(engine_t* engine, int threads, int hash_mb){
+	if(threads < 1){
+		threads = 1;
+	}
+	if(threads > MAX_THREADS){
+		threads = MAX_THREADS;
+	}
+	engine -> searchers = (searcher_t*)malloc(threads * sizeof(searcher_t));
+	if(!engine -> searchers){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	if(!tt_create(&engine -> hash, hash_mb)){
+		free(engine -> searchers);
+		engine -> searchers = nullptr;
+		return 0;
+	}
+	engine -> threads = threads;
+	engine -> book = nullptr;
+	engine -> bookrandom = search_clock() | 1;
+	searchshared_init(&engine -> shared, &engine -> hash);
+	engine -> job = 0;
+	engine -> state = ENGINE_IDLE;
+	engine -> cancel = 0;
+	engine -> finished = 0;
+	engine -> quit = 0;
+	engine -> mailbox = 0;
+	engine -> done = nullptr;
+	engine -> user = nullptr;
+	engine -> worker = std::thread(engine_worker, engine);
+	return 1;
+}
+
+//cancel whatever is running and wait for the worker to exit
+inline void engine_free(engine_t* engine){
+	engine -> cancel.store(1, std::memory_order_release);
+	engine -> shared.stop.store(1, std::memory_order_release);
+	engine -> quit.store(1, std::memory_order_release);
+	engine_wake(engine);
+	engine -> worker.join();
+	tt_free(&engine -> hash);
+	free(engine -> searchers);
+	engine -> searchers = nullptr;
+}
+
+inline int engine_idle(const engine_t* engine){
+	return engine -> state.load(std::memory_order_acquire) == ENGINE_IDLE;
+}
+
+//start searching pos, returns the job's id, or 0 if the worker is still busy and the caller
+//should try again later
+inline uint32_t engine_go(engine_t* engine, const position_t* pos, searchlimits_t limits, int ponder){
+	if(!engine_idle(engine)){
+		return 0;
+	}
+	engine -> pos = *pos;
+	engine -> limits = limits;
+	engine -> job++;
+	if(!engine -> job){
+		engine -> job = 1;
+	}
+	engine -> mailbox.store(0, std::memory_order_relaxed);
+	engine -> cancel.store(0, std::memory_order_relaxed);
+	engine -> finished.store(0, std::memory_order_relaxed);
+	engine -> shared.stop.store(0, std::memory_order_relaxed);
+	engine -> shared.deadline.store(0, std::memory_order_relaxed);
+	engine -> shared.ponder.store(ponder, std::memory_order_relaxed);
+	tt_newsearch(&engine -> hash);
+	engine -> state.store(ENGINE_BUSY, std::memory_order_release);
+	engine_wake(engine);
+	return engine -> job;
+}
+
+//the opponent played the expected reply, the pondering job becomes a normal one with its full time
+inline void engine_ponderhit(engine_t* engine){
+	if(engine -> limits.movetime > 0){
+		engine -> shared.deadline.store(search_clock() + (unsigned long)engine -> limits.movetime * 1000000, std::memory_order_relaxed);
+	}
+	engine -> shared.ponder.store(0, std::memory_order_release);
+	engine_wake(engine);
+}
+
+//end the running job early and post its best move so far, as a protocol "stop" wants
+inline void engine_finish(engine_t* engine){
+	engine -> finished.store(1, std::memory_order_release);
+	engine -> shared.ponder.store(0, std::memory_order_release);
+	engine -> shared.stop.store(1, std::memory_order_release);
+	engine_wake(engine);
+}
+
+//drop the running job, nothing is posted for it and the worker goes idle shortly after
+inline void engine_stop(engine_t* engine){
+	engine -> cancel.store(1, std::memory_order_release);
+	engine -> shared.stop.store(1, std::memory_order_release);
+	engine_wake(engine);
+}
+
+//take the answer to job out of the mailbox, returns 0 if it isn't there yet
+inline int engine_takemove(engine_t* engine, uint32_t job, move_t* move, move_t* ponder){
+	uint64_t mail = engine -> mailbox.load(std::memory_order_acquire);
+	if(!mail || (uint32_t)(mail >> 32) != job){
+		return 0;
+	}
+	engine -> mailbox.store(0, std::memory_order_relaxed);
+	*move = (move_t)(mail & 0xFFFF);
+	if(ponder){
+		*ponder = (move_t)((mail >> 16) & 0xFFFF);
+	}
+	return 1;
+}
+
+#endif
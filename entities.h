@@ -0,0 +1,134 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//entities of one kind kept as parallel arrays, one per field, packed at the front with no gaps.
+//a loop over positions only reads positions, front to back, and nothing is allocated after
+//entities_create however many spawn and die
+//
+//removing moves the last entity into the hole, so indices aren't stable: a loop that removes
+//the entity it's on looks at the same index again instead of moving on
+
+struct entities_s{
+	int* x;
+	int* y;
+	int* width;
+	int* height;
+	//where each was before the last tick, drawing goes between the two
+	int* previousx;
+	int* previousy;
+	//asset handle each is drawn with
+	int* asset;
+	int count;
+	int capacity;
+	//most there have been at once, to tell whether capacity is ever reached
+	int peak;
+};
+
+typedef struct entities_s entities_t;
+
+//room for capacity entities, returns 0 on failure
+inline int entities_create(entities_t* entities, int capacity){
+	int* fields = (int*)malloc((size_t)capacity * 7 * sizeof(int));
+	if(!fields){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	entities -> x = fields;
+	entities -> y = fields + capacity;
+	entities -> width = fields + capacity * 2;
+	entities -> height = fields + capacity * 3;
+	entities -> asset = fields + capacity * 4;
+	entities -> previousx = fields + capacity * 5;
+	entities -> previousy = fields + capacity * 6;
+	entities -> count = 0;
+	entities -> capacity = capacity;
+	entities -> peak = 0;
+	return 1;
+}
+
+inline void entities_free(entities_t* entities){
+	free(entities -> x);
+	entities -> x = entities -> y = entities -> width = entities -> height = entities -> asset = nullptr;
+	entities -> previousx = entities -> previousy = nullptr;
+	entities -> count = 0;
+	entities -> capacity = 0;
+	entities -> peak = 0;
+}
+
+//returns the new entity's index, or -1 if there's no room. it starts out as if it had been there
+//the tick before, so it isn't drawn sliding in from somewhere
+inline int entities_add(entities_t* entities, int asset, int x, int y, int width, int height){
+	if(entities -> count == entities -> capacity){
+		return -1;
+	}
+	int i = entities -> count++;
+	if(entities -> count > entities -> peak){
+		entities -> peak = entities -> count;
+	}
+	entities -> x[i] = x;
+	entities -> y[i] = y;
+	entities -> width[i] = width;
+	entities -> height[i] = height;
+	entities -> asset[i] = asset;
+	entities -> previousx[i] = x;
+	entities -> previousy[i] = y;
+	return i;
+}
+
+inline void entities_remove(entities_t* entities, int i){
+	int last = --entities -> count;
+	entities -> x[i] = entities -> x[last];
+	entities -> y[i] = entities -> y[last];
+	entities -> width[i] = entities -> width[last];
+	entities -> height[i] = entities -> height[last];
+	entities -> asset[i] = entities -> asset[last];
+	entities -> previousx[i] = entities -> previousx[last];
+	entities -> previousy[i] = entities -> previousy[last];
+}
+
+//remember where everything is, before a tick moves it
+inline void entities_keep(entities_t* entities){
+	memcpy(entities -> previousx, entities -> x, entities -> count * sizeof(int));
+	memcpy(entities -> previousy, entities -> y, entities -> count * sizeof(int));
+}
+
+//function to check if point is inside rectangle
+inline int point_in_rect(int rect_x, int rect_y, int rect_width, int rect_height, int x, int y){
+	if(x >= rect_x && x <= rect_x + rect_width){
+		if(y >= rect_y && y <= rect_y + rect_height){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+//uses point_in_rect to check if any corner of projectile p is inside alien a
+inline int collides(const entities_t* projectiles, int p, const entities_t* aliens, int a){
+	int x = aliens -> x[a];
+	int y = aliens -> y[a];
+	int width = aliens -> width[a];
+	int height = aliens -> height[a];
+	int left = projectiles -> x[p];
+	int top = projectiles -> y[p];
+	int right = left + projectiles -> width[p];
+	int bottom = top + projectiles -> height[p];
+	if(point_in_rect(x, y, width, height, left, top)){
+		return 1;
+	}
+	if(point_in_rect(x, y, width, height, right, top)){
+		return 1;
+	}
+	if(point_in_rect(x, y, width, height, left, bottom)){
+		return 1;
+	}
+	if(point_in_rect(x, y, width, height, right, bottom)){
+		return 1;
+	}
+	return 0;
+}
+
+#endif
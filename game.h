@@ -0,0 +1,239 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "entities.h"
+#include "grid.h"
+
+//space invaders without a window: everything a tick does, from the keys held during it
+//
+//a game is a function of its seed and the input of every tick. the size of the play area is fixed
+//when it's created, random numbers come from the game's own generator and nothing reads the
+//clock, so the same seed and input always play out the same, with a window or without
+
+//keys held during a tick, or'd together
+const int GAME_UP = 1;
+const int GAME_LEFT = 2;
+const int GAME_DOWN = 4;
+const int GAME_RIGHT = 8;
+const int GAME_FIRE = 16;
+
+const int GAME_TPS = 60;
+const int GAME_PROJECTILES = 128;
+const int GAME_ALIENS = 10;
+
+//the player's ship. asset is a handle from the asset manager
+struct entity_s{
+	int asset;
+	int x;
+	int y;
+	int width;
+	int height;
+	//where it was before the last tick
+	int previousx;
+	int previousy;
+};
+
+typedef struct entity_s entity_t;
+
+struct game_s{
+	int width;
+	int height;
+	entity_t spaceship;
+	entities_t projectiles;
+	entities_t aliens;
+	//projectiles only test the aliens near them, cells a bit bigger than an alien
+	grid_t grid;
+	int projectile_asset;
+	int alien_asset;
+	int cooldown;
+	int aliencooldown;
+	unsigned long random;
+	//ticks played, aliens spawned and aliens shot
+	long ticks;
+	long spawned;
+	long score;
+};
+
+typedef struct game_s game_t;
+
+//the same generator everywhere
+inline unsigned int game_random(game_t* game){
+	game -> random = game -> random * 6364136223846793005UL + 1442695040888963407UL;
+	return (unsigned int)(game -> random >> 33);
+}
+
+//new game on a width by height area, entities drawn with the asset handles given. returns 0 on
+//failure
+inline int game_create(game_t* game, int width, int height, unsigned long seed, int spaceship_asset, int projectile_asset, int alien_asset){
+	if(width <= 100 || height <= 100){
+		printf("Failed to create game, %dx%d is too small\n", width, height);
+		return 0;
+	}
+	game -> width = width;
+	game -> height = height;
+	game -> spaceship = {spaceship_asset, 0, 0, 100, 100, 0, 0};
+	game -> projectile_asset = projectile_asset;
+	game -> alien_asset = alien_asset;
+	game -> cooldown = 0;
+	game -> aliencooldown = 0;
+	game -> random = seed;
+	game -> ticks = 0;
+	game -> spawned = 0;
+	game -> score = 0;
+
+	if(!entities_create(&game -> projectiles, GAME_PROJECTILES)){
+		return 0;
+	}
+	if(!entities_create(&game -> aliens, GAME_ALIENS)){
+		entities_free(&game -> projectiles);
+		return 0;
+	}
+	if(!grid_create(&game -> grid, width, height, 128)){
+		entities_free(&game -> projectiles);
+		entities_free(&game -> aliens);
+		return 0;
+	}
+	return 1;
+}
+
+inline void game_free(game_t* game){
+	entities_free(&game -> projectiles);
+	entities_free(&game -> aliens);
+	grid_free(&game -> grid);
+}
+
+//fnv-1a, one int at a time
+inline uint64_t game_hashint(uint64_t hash, int64_t v){
+	for(int i = 0; i < 8; i++){
+		hash = (hash ^ (uint8_t)(v >> i * 8)) * 1099511628211UL;
+	}
+	return hash;
+}
+
+inline uint64_t game_hashentities(uint64_t hash, const entities_t* entities){
+	hash = game_hashint(hash, entities -> count);
+	for(int i = 0; i < entities -> count; i++){
+		hash = game_hashint(hash, entities -> x[i]);
+		hash = game_hashint(hash, entities -> y[i]);
+		hash = game_hashint(hash, entities -> width[i]);
+		hash = game_hashint(hash, entities -> height[i]);
+	}
+	return hash;
+}
+
+//hash of everything that decides how the game goes on, so two games with the same hash play the
+//rest the same given the same input. asset handles are left out, they only matter for drawing
+inline uint64_t game_hash(const game_t* game){
+	uint64_t hash = 14695981039346656037UL;
+	hash = game_hashint(hash, game -> width);
+	hash = game_hashint(hash, game -> height);
+	hash = game_hashint(hash, game -> spaceship.x);
+	hash = game_hashint(hash, game -> spaceship.y);
+	hash = game_hashint(hash, game -> cooldown);
+	hash = game_hashint(hash, game -> aliencooldown);
+	hash = game_hashint(hash, (int64_t)game -> random);
+	hash = game_hashint(hash, game -> ticks);
+	hash = game_hashint(hash, game -> spawned);
+	hash = game_hashint(hash, game -> score);
+	hash = game_hashentities(hash, &game -> projectiles);
+	return game_hashentities(hash, &game -> aliens);
+}
+
+//one tick with the keys in input held. returns 1 while the game goes on, 0 once an alien reaches
+//the bottom and -1 on failure
+inline int game_tick(game_t* game, int input){
+	entity_t* spaceship = &game -> spaceship;
+	entities_t* projectiles = &game -> projectiles;
+	entities_t* aliens = &game -> aliens;
+	const int projectileWidth = 20;
+	const int projectileHeight = 100;
+	const int alienWidth = 100;
+	const int alienHeight = 100;
+
+	spaceship -> previousx = spaceship -> x;
+	spaceship -> previousy = spaceship -> y;
+	entities_keep(projectiles);
+	entities_keep(aliens);
+	game -> ticks++;
+
+	//move ship if WASD pressed
+	if(input & GAME_UP){
+		spaceship -> y -= 10;
+	}
+	if(input & GAME_LEFT){
+		spaceship -> x -= 10;
+	}
+	if(input & GAME_DOWN){
+		spaceship -> y += 10;
+	}
+	if(input & GAME_RIGHT){
+		spaceship -> x += 10;
+	}
+	//Make sure ship cant go out of bounds
+	if(spaceship -> x + spaceship -> width > game -> width){
+		spaceship -> x = game -> width - spaceship -> width;
+	}
+	if(spaceship -> x < 0){
+		spaceship -> x = 0;
+	}
+	if(spaceship -> y + spaceship -> height > game -> height){
+		spaceship -> y = game -> height - spaceship -> height;
+	}
+	if(spaceship -> y < 0){
+		spaceship -> y = 0;
+	}
+
+	if(game -> cooldown)
+		game -> cooldown--;
+
+	if(game -> aliencooldown)
+		game -> aliencooldown--;
+
+	//If space pressed and there's room, shoot projectile from the middle of the ship
+	if((input & GAME_FIRE) && !game -> cooldown){
+		if(entities_add(projectiles, game -> projectile_asset, spaceship -> x + spaceship -> width / 2 - projectileWidth / 2, spaceship -> y - projectileHeight, projectileWidth, projectileHeight) >= 0){
+			game -> cooldown = GAME_TPS / 8;
+		}
+	}
+	for(int i = 0; i < projectiles -> count; i++){
+		//move projectiles up
+		projectiles -> y[i] -= 35;
+	}
+	//remove projectiles that are oob, whatever moves into the hole is checked next
+	for(int i = 0; i < projectiles -> count; ){
+		if(projectiles -> y[i] < -projectiles -> height[i]){
+			entities_remove(projectiles, i);
+		} else{
+			i++;
+		}
+	}
+	if(!game -> aliencooldown){
+		//make alien with random x coordinate if there's room
+		int i = entities_add(aliens, game -> alien_asset, 0, 0, alienWidth, alienHeight);
+		if(i >= 0){
+			aliens -> x[i] = aliens -> previousx[i] = game_random(game) % (game -> width - alienWidth);
+			game -> spawned++;
+
+			game -> aliencooldown = 20;
+		}
+	}
+	for(int i = 0; i < aliens -> count; i++){
+		//move aliens down
+		aliens -> y[i] += 5;
+		//if alien reaches bottom, game over
+		if(aliens -> y[i] > game -> height - aliens -> height[i]){
+			return 0;
+		}
+	}
+	//if alien and proj collide, remove both
+	int hits = grid_collide(&game -> grid, projectiles, aliens);
+	if(hits < 0){
+		return -1;
+	}
+	game -> score += hits;
+	return 1;
+}
+
+#endif
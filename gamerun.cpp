@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+#include "replay.h"
+#include "nanotime.h"
+
+//plays space invaders without a window, as fast as it goes
+//usage: gamerun [games] [seed] [max ticks] [width] [height]    defaults 1000, 1, 3600, 1000 and 1000
+//       gamerun -r file [seed] [max ticks] [width] [height]   record one game to file
+//       gamerun -p file [rounds]                               replay file, default once
+//game i is seeded with seed + i and played by script below. a game ends when an alien gets
+//through or after max ticks. the same arguments always give the same totals
+//
+//a replay checks the game against every hash in the recording and fails on the first that
+//doesn't match. played more than once it's a benchmark of the same ticks every round
+
+//keys for the next tick: stay at the bottom, get under the lowest alien and fire once under it
+int script(const game_t* game){
+	const entity_t* spaceship = &game -> spaceship;
+	int input = GAME_DOWN;
+	int target = -1;
+	for(int i = 0; i < game -> aliens.count; i++){
+		if(target < 0 || game -> aliens.y[i] > game -> aliens.y[target]){
+			target = i;
+		}
+	}
+	if(target < 0){
+		return input;
+	}
+	int middle = spaceship -> x + spaceship -> width / 2;
+	int alien = game -> aliens.x[target] + game -> aliens.width[target] / 2;
+	if(middle < alien - 5){
+		input |= GAME_RIGHT;
+	} else if(middle > alien + 5){
+		input |= GAME_LEFT;
+	}
+	if(middle > game -> aliens.x[target] && middle < game -> aliens.x[target] + game -> aliens.width[target]){
+		input |= GAME_FIRE;
+	}
+	return input;
+}
+
+//play and record one scripted game
+int record(const char* filename, unsigned long seed, long maxticks, int width, int height){
+	game_t game;
+	recorder_t recorder;
+	if(!game_create(&game, width, height, seed, 0, 0, 0)){
+		return -1;
+	}
+	if(!recorder_open(&recorder, filename, &game, seed)){
+		game_free(&game);
+		return -1;
+	}
+	int playing = 1;
+	while(playing > 0 && game.ticks < maxticks){
+		int input = script(&game);
+		playing = game_tick(&game, input);
+		recorder_tick(&recorder, &game, input);
+	}
+	int ok = recorder_close(&recorder, &game) && playing >= 0;
+	printf("recorded %ld ticks spawned %ld shot %ld hash %016llx\n", game.ticks, game.spawned, game.score, (unsigned long long)game_hash(&game));
+	game_free(&game);
+	return ok ? 0 : -1;
+}
+
+int replay(const char* filename, int rounds){
+	replay_t replay;
+	if(!replay_open(&replay, filename)){
+		return -1;
+	}
+	unsigned long best = -1;
+	for(int r = 0; r < rounds; r++){
+		game_t game;
+		if(!game_create(&game, replay.width, replay.height, replay.seed, 0, 0, 0)){
+			replay_close(&replay);
+			return -1;
+		}
+		replay_rewind(&replay);
+		unsigned long start = nanotime();
+		int input;
+		while((input = replay_input(&replay, &game)) >= 0){
+			if(game_tick(&game, input) < 0){
+				input = REPLAY_DIVERGED;
+				break;
+			}
+		}
+		unsigned long time = nanotime() - start;
+		if(input == REPLAY_DIVERGED){
+			game_free(&game);
+			replay_close(&replay);
+			return -1;
+		}
+		if(time < best){
+			best = time;
+		}
+		if(r == rounds - 1){
+			printf("replayed %ld ticks spawned %ld shot %ld hash %016llx, matches\n", game.ticks, game.spawned, game.score, (unsigned long long)game_hash(&game));
+			printf("best of %d %.3fms %.0f ticks/s\n", rounds, best / 1e6, game.ticks / (best / 1e9));
+		}
+		game_free(&game);
+	}
+	replay_close(&replay);
+	return 0;
+}
+
+int main(int argc, char** argv){
+	if(argc > 2 && !strcmp(argv[1], "-r")){
+		return record(argv[2], argc > 3 ? strtoul(argv[3], nullptr, 10) : 1, argc > 4 ? atol(argv[4]) : 3600,
+		              argc > 5 ? atoi(argv[5]) : 1000, argc > 6 ? atoi(argv[6]) : 1000);
+	}
+	if(argc > 2 && !strcmp(argv[1], "-p")){
+		int rounds = argc > 3 ? atoi(argv[3]) : 1;
+		return replay(argv[2], rounds > 0 ? rounds : 1);
+	}
+	long games = argc > 1 ? atol(argv[1]) : 1000;
+	unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+	long maxticks = argc > 3 ? atol(argv[3]) : 3600;
+	int width = argc > 4 ? atoi(argv[4]) : 1000;
+	int height = argc > 5 ? atoi(argv[5]) : 1000;
+	if(games < 1 || maxticks < 1){
+		printf("usage: gamerun [games] [seed] [max ticks] [width] [height]\n");
+		printf("       gamerun -r file [seed] [max ticks] [width] [height]\n");
+		printf("       gamerun -p file [rounds]\n");
+		return -1;
+	}
+
+	long ticks = 0;
+	long lost = 0;
+	long spawned = 0;
+	long score = 0;
+	int projectilepeak = 0;
+	int alienpeak = 0;
+	unsigned long start = nanotime();
+	for(long g = 0; g < games; g++){
+		game_t game;
+		if(!game_create(&game, width, height, seed + g, 0, 0, 0)){
+			return -1;
+		}
+		int playing = 1;
+		while(playing > 0 && game.ticks < maxticks){
+			playing = game_tick(&game, script(&game));
+		}
+		if(playing < 0){
+			return -1;
+		}
+		lost += !playing;
+		ticks += game.ticks;
+		spawned += game.spawned;
+		score += game.score;
+		if(game.projectiles.peak > projectilepeak){
+			projectilepeak = game.projectiles.peak;
+		}
+		if(game.aliens.peak > alienpeak){
+			alienpeak = game.aliens.peak;
+		}
+		game_free(&game);
+	}
+	unsigned long time = nanotime() - start;
+
+	printf("games %ld lost %ld ticks %ld spawned %ld shot %ld\n", games, lost, ticks, spawned, score);
+	printf("average %.1f ticks %.1f shot, %.3fs %.0f games/s %.0f ticks/s\n", (double)ticks / games, (double)score / games,
+	       time / 1e9, games / (time / 1e9), ticks / (time / 1e9));
+	printf("most at once: projectiles %d of %d aliens %d of %d\n", projectilepeak, GAME_PROJECTILES, alienpeak, GAME_ALIENS);
+	return 0;
+}
@@ -0,0 +1,256 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "entities.h"
+#include "collide.h"
+
+//uniform grid over the play area for finding which aliens a projectile can hit without trying
+//every one of them
+//
+//grid_build files every alien under each square cell its rectangle touches, edges included,
+//with a counting sort into one array, so a rebuild every tick is two passes over the aliens and
+//allocates nothing once the arrays are big enough. a projectile corner can then only be inside
+//aliens filed under that corner's cell. anything past the edge of the grid is filed under the
+//nearest edge cell, so entities off screen still meet the ones they overlap
+//
+//each filed alien's rectangle is copied next to it in cell order, so a cell's aliens are tested
+//straight from contiguous arrays a block at a time by collide_block
+
+struct grid_s{
+	int cellsize;
+	int columns;
+	int rows;
+	//aliens in cell c are items[starts[c]] up to items[starts[c + 1]], with their rectangles at
+	//the same places in the other four
+	int* starts;
+	int* items;
+	int* itemx;
+	int* itemy;
+	int* itemwidth;
+	int* itemheight;
+	int itemcapacity;
+	//per alien whether it's been hit, and per projectile whether it hit
+	unsigned char* alienhit;
+	int aliencapacity;
+	unsigned char* projectilehit;
+	int projectilecapacity;
+};
+
+typedef struct grid_s grid_t;
+
+//grid of cellsize squares covering width by height, returns 0 on failure
+inline int grid_create(grid_t* grid, int width, int height, int cellsize){
+	grid -> cellsize = cellsize;
+	grid -> columns = (width + cellsize - 1) / cellsize;
+	grid -> rows = (height + cellsize - 1) / cellsize;
+	if(grid -> columns < 1){
+		grid -> columns = 1;
+	}
+	if(grid -> rows < 1){
+		grid -> rows = 1;
+	}
+	grid -> starts = (int*)malloc(((size_t)grid -> columns * grid -> rows + 1) * sizeof(int));
+	grid -> items = nullptr;
+	grid -> itemcapacity = 0;
+	grid -> alienhit = nullptr;
+	grid -> aliencapacity = 0;
+	grid -> projectilehit = nullptr;
+	grid -> projectilecapacity = 0;
+	if(!grid -> starts){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	return 1;
+}
+
+inline void grid_free(grid_t* grid){
+	free(grid -> starts);
+	free(grid -> items);
+	free(grid -> alienhit);
+	free(grid -> projectilehit);
+	grid -> starts = nullptr;
+	grid -> items = nullptr;
+	grid -> alienhit = nullptr;
+	grid -> projectilehit = nullptr;
+}
+
+//make sure *array has room for count elements of size bytes, returns 0 on failure
+inline int grid_reserve(void** array, int* capacity, int count, size_t size){
+	if(count <= *capacity){
+		return 1;
+	}
+	int grown = *capacity ? *capacity : 64;
+	while(grown < count){
+		grown *= 2;
+	}
+	void* larger = realloc(*array, grown * size);
+	if(!larger){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	*array = larger;
+	*capacity = grown;
+	return 1;
+}
+
+//room for count filed aliens, plus a block past the end that collide_block may read. returns 0 on
+//failure
+inline int grid_reserveitems(grid_t* grid, int count){
+	if(count + COLLIDE_BLOCK <= grid -> itemcapacity){
+		return 1;
+	}
+	int capacity = grid -> itemcapacity ? grid -> itemcapacity : 64;
+	while(capacity < count + COLLIDE_BLOCK){
+		capacity *= 2;
+	}
+	//everything is filled again by the build, nothing has to be kept. cleared so the lanes past the
+	//end are never uninitialized
+	free(grid -> items);
+	grid -> items = (int*)calloc((size_t)capacity * 5, sizeof(int));
+	if(!grid -> items){
+		grid -> itemcapacity = 0;
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	grid -> itemx = grid -> items + capacity;
+	grid -> itemy = grid -> items + capacity * 2;
+	grid -> itemwidth = grid -> items + capacity * 3;
+	grid -> itemheight = grid -> items + capacity * 4;
+	grid -> itemcapacity = capacity;
+	return 1;
+}
+
+//column or row of coordinate v, clamped to the grid
+inline int grid_cell(const grid_t* grid, int v, int cells){
+	if(v < 0){
+		return 0;
+	}
+	v /= grid -> cellsize;
+	return v < cells ? v : cells - 1;
+}
+
+//file every alien under the cells it touches, returns 0 on failure
+inline int grid_build(grid_t* grid, const entities_t* aliens){
+	int cells = grid -> columns * grid -> rows;
+	memset(grid -> starts, 0, ((size_t)cells + 1) * sizeof(int));
+
+	//count each cell's aliens, one further along so the sums below come out as starts
+	int total = 0;
+	for(int i = 0; i < aliens -> count; i++){
+		int x0 = grid_cell(grid, aliens -> x[i], grid -> columns);
+		int x1 = grid_cell(grid, aliens -> x[i] + aliens -> width[i], grid -> columns);
+		int y0 = grid_cell(grid, aliens -> y[i], grid -> rows);
+		int y1 = grid_cell(grid, aliens -> y[i] + aliens -> height[i], grid -> rows);
+		for(int y = y0; y <= y1; y++){
+			for(int x = x0; x <= x1; x++){
+				grid -> starts[y * grid -> columns + x + 1]++;
+			}
+		}
+		total += (x1 - x0 + 1) * (y1 - y0 + 1);
+	}
+	if(!grid_reserveitems(grid, total)){
+		return 0;
+	}
+	for(int c = 0; c < cells; c++){
+		grid -> starts[c + 1] += grid -> starts[c];
+	}
+
+	//fill each cell from its start, which leaves every start moved up to the next cell's
+	for(int i = 0; i < aliens -> count; i++){
+		int x0 = grid_cell(grid, aliens -> x[i], grid -> columns);
+		int x1 = grid_cell(grid, aliens -> x[i] + aliens -> width[i], grid -> columns);
+		int y0 = grid_cell(grid, aliens -> y[i], grid -> rows);
+		int y1 = grid_cell(grid, aliens -> y[i] + aliens -> height[i], grid -> rows);
+		for(int y = y0; y <= y1; y++){
+			for(int x = x0; x <= x1; x++){
+				int k = grid -> starts[y * grid -> columns + x]++;
+				grid -> items[k] = i;
+				grid -> itemx[k] = aliens -> x[i];
+				grid -> itemy[k] = aliens -> y[i];
+				grid -> itemwidth[k] = aliens -> width[i];
+				grid -> itemheight[k] = aliens -> height[i];
+			}
+		}
+	}
+	//and so moved back
+	for(int c = cells; c > 0; c--){
+		grid -> starts[c] = grid -> starts[c - 1];
+	}
+	grid -> starts[0] = 0;
+	return 1;
+}
+
+//first alien not yet hit that a corner of projectile p is inside, -1 if none
+inline int grid_find(const grid_t* grid, const entities_t* projectiles, int p){
+	int left = projectiles -> x[p];
+	int top = projectiles -> y[p];
+	int right = left + projectiles -> width[p];
+	int bottom = top + projectiles -> height[p];
+	int x0 = grid_cell(grid, left, grid -> columns);
+	int x1 = grid_cell(grid, right, grid -> columns);
+	int y0 = grid_cell(grid, top, grid -> rows);
+	int y1 = grid_cell(grid, bottom, grid -> rows);
+	//corners only ever land in the cells at the ends of each range
+	for(int y = y0; y <= y1; y += y1 - y0 > 0 ? y1 - y0 : 1){
+		for(int x = x0; x <= x1; x += x1 - x0 > 0 ? x1 - x0 : 1){
+			int cell = y * grid -> columns + x;
+			int end = grid -> starts[cell + 1];
+			for(int k = grid -> starts[cell]; k < end; k += COLLIDE_BLOCK){
+				int count = end - k < COLLIDE_BLOCK ? end - k : COLLIDE_BLOCK;
+				uint32_t mask = collide_block(left, top, right, bottom, grid -> itemx + k, grid -> itemy + k, grid -> itemwidth + k, grid -> itemheight + k, count);
+				while(mask){
+					int a = grid -> items[k + __builtin_ctz(mask)];
+					mask &= mask - 1;
+					if(!grid -> alienhit[a]){
+						return a;
+					}
+				}
+			}
+		}
+	}
+	return -1;
+}
+
+//remove every projectile that hits an alien along with the alien, each alien stopping at most
+//one projectile as when every pair was tried. returns how many pairs hit, -1 on failure
+inline int grid_collide(grid_t* grid, entities_t* projectiles, entities_t* aliens){
+	//nothing can hit, and the arrays below may not exist yet
+	if(!projectiles -> count || !aliens -> count){
+		return 0;
+	}
+	if(!grid_build(grid, aliens)
+	  || !grid_reserve((void**)&grid -> alienhit, &grid -> aliencapacity, aliens -> count, 1)
+	  || !grid_reserve((void**)&grid -> projectilehit, &grid -> projectilecapacity, projectiles -> count, 1)){
+		return -1;
+	}
+	memset(grid -> alienhit, 0, aliens -> count);
+	memset(grid -> projectilehit, 0, projectiles -> count);
+
+	//hits are only marked here, removing would move entities the grid still points at
+	int hits = 0;
+	for(int p = 0; p < projectiles -> count; p++){
+		int a = grid_find(grid, projectiles, p);
+		if(a >= 0){
+			grid -> alienhit[a] = 1;
+			grid -> projectilehit[p] = 1;
+			hits++;
+		}
+	}
+	//from the back, so whatever moves into a hole has already been looked at and stays
+	for(int a = aliens -> count - 1; hits && a >= 0; a--){
+		if(grid -> alienhit[a]){
+			entities_remove(aliens, a);
+		}
+	}
+	for(int p = projectiles -> count - 1; hits && p >= 0; p--){
+		if(grid -> projectilehit[p]){
+			entities_remove(projectiles, p);
+		}
+	}
+	return hits;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+
+//images as plain RGBA pixels in memory, for whatever needs to touch them before they're a texture
+
+//decoded RGBA pixels, rows from the top
+struct image_s{
+	unsigned char* pixels;
+	int width;
+	int height;
+};
+
+typedef struct image_s image_t;
+
+//decode a png, returns 0 on failure
+inline int image_load(image_t* image, const char* filename){
+	png_image png;
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	if(!png_image_begin_read_from_file(&png, filename)){
+		printf("Failed to read %s\n", filename);
+		return 0;
+	}
+	png.format = PNG_FORMAT_RGBA;
+	image -> pixels = (unsigned char*)malloc(PNG_IMAGE_SIZE(png));
+	if(!image -> pixels){
+		png_image_free(&png);
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	if(!png_image_finish_read(&png, nullptr, image -> pixels, 0, nullptr)){
+		free(image -> pixels);
+		image -> pixels = nullptr;
+		printf("Failed to decode %s\n", filename);
+		return 0;
+	}
+	image -> width = png.width;
+	image -> height = png.height;
+	return 1;
+}
+
+inline void image_free(image_t* image){
+	free(image -> pixels);
+	image -> pixels = nullptr;
+}
+
+//the area of image under each destination pixel averaged into a width by height picture at out,
+//with rows stride bytes apart. color is weighted by alpha so transparent edges don't go dark
+inline void image_resample(const image_t* image, unsigned char* out, int stride, int width, int height){
+	for(int y = 0; y < height; y++){
+		int y0 = y * image -> height / height;
+		int y1 = (y + 1) * image -> height / height;
+		if(y1 <= y0){
+			y1 = y0 + 1;
+		}
+		for(int x = 0; x < width; x++){
+			int x0 = x * image -> width / width;
+			int x1 = (x + 1) * image -> width / width;
+			if(x1 <= x0){
+				x1 = x0 + 1;
+			}
+			unsigned long sum[4] = {0, 0, 0, 0};
+			for(int sy = y0; sy < y1; sy++){
+				const unsigned char* p = image -> pixels + ((size_t)sy * image -> width + x0) * 4;
+				for(int sx = x0; sx < x1; sx++, p += 4){
+					sum[0] += p[0] * p[3];
+					sum[1] += p[1] * p[3];
+					sum[2] += p[2] * p[3];
+					sum[3] += p[3];
+				}
+			}
+			unsigned char* q = out + (size_t)y * stride + x * 4;
+			unsigned long count = (unsigned long)(x1 - x0) * (y1 - y0);
+			for(int c = 0; c < 3; c++){
+				q[c] = sum[3] ? sum[c] / sum[3] : 0;
+			}
+			q[3] = sum[3] / count;
+		}
+	}
+}
+
+#endif
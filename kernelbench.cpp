@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "entities.h"
+#include "collide.h"
+#include "nanotime.h"
+
+//collide_block against collides one pair at a time, every projectile against every alien
+//usage: kernelbench [projectiles] [aliens] [rounds]    defaults 2000, 4096 and 5
+//positions are multiples of 10 on a small field, so rectangles often share an edge exactly and
+//the edge cases get as much testing as the rest. both ways have to give the same mask for every
+//block before anything is timed
+
+unsigned int benchrandom(unsigned long* state){
+	*state = *state * 6364136223846793005UL + 1442695040888963407UL;
+	return (unsigned int)(*state >> 33);
+}
+
+//mask of the aliens from start on that projectile p hits, one collides at a time
+uint32_t pairs_block(const entities_t* projectiles, int p, const entities_t* aliens, int start, int count){
+	uint32_t mask = 0;
+	for(int i = 0; i < count; i++){
+		mask |= (uint32_t)collides(projectiles, p, aliens, start + i) << i;
+	}
+	return mask;
+}
+
+uint32_t kernel_block(const entities_t* projectiles, int p, const entities_t* aliens, int start, int count){
+	int left = projectiles -> x[p];
+	int top = projectiles -> y[p];
+	return collide_block(left, top, left + projectiles -> width[p], top + projectiles -> height[p],
+	                     aliens -> x + start, aliens -> y + start, aliens -> width + start, aliens -> height + start, count);
+}
+
+//all pairs a block at a time, returns how many hit
+long run(uint32_t (*block)(const entities_t*, int, const entities_t*, int, int), const entities_t* projectiles, const entities_t* aliens){
+	long hits = 0;
+	for(int p = 0; p < projectiles -> count; p++){
+		for(int a = 0; a < aliens -> count; a += COLLIDE_BLOCK){
+			int count = aliens -> count - a < COLLIDE_BLOCK ? aliens -> count - a : COLLIDE_BLOCK;
+			hits += __builtin_popcount(block(projectiles, p, aliens, a, count));
+		}
+	}
+	return hits;
+}
+
+int main(int argc, char** argv){
+	int projectilecount = argc > 1 ? atoi(argv[1]) : 2000;
+	int aliencount = argc > 2 ? atoi(argv[2]) : 4096;
+	int rounds = argc > 3 ? atoi(argv[3]) : 5;
+	if(projectilecount < 1 || aliencount < 1 || rounds < 1){
+		printf("usage: kernelbench [projectiles] [aliens] [rounds]\n");
+		return -1;
+	}
+#if defined(__AVX2__)
+	printf("kernel avx2\n");
+#elif defined(__SSE2__)
+	printf("kernel sse2\n");
+#else
+	printf("kernel scalar\n");
+#endif
+
+	entities_t projectiles;
+	entities_t aliens;
+	//collide_block reads a whole block past the last alien
+	if(!entities_create(&projectiles, projectilecount) || !entities_create(&aliens, aliencount + COLLIDE_BLOCK)){
+		return -1;
+	}
+	unsigned long state = 1;
+	for(int i = 0; i < projectilecount; i++){
+		entities_add(&projectiles, 0, benchrandom(&state) % 100 * 10, benchrandom(&state) % 100 * 10, 20, 100);
+	}
+	for(int i = 0; i < aliencount + COLLIDE_BLOCK; i++){
+		entities_add(&aliens, 0, benchrandom(&state) % 100 * 10, benchrandom(&state) % 100 * 10, 100, 100);
+	}
+	aliens.count = aliencount;
+
+	for(int p = 0; p < projectiles.count; p++){
+		for(int a = 0; a < aliens.count; a += COLLIDE_BLOCK){
+			int count = aliens.count - a < COLLIDE_BLOCK ? aliens.count - a : COLLIDE_BLOCK;
+			if(pairs_block(&projectiles, p, &aliens, a, count) != kernel_block(&projectiles, p, &aliens, a, count)){
+				printf("projectile %d aliens %d: masks differ\n", p, a);
+				return -1;
+			}
+		}
+	}
+
+	unsigned long pairtime = -1;
+	unsigned long kerneltime = -1;
+	long pairhits = 0;
+	long kernelhits = 0;
+	//best of a few rounds, so a stray interruption doesn't decide it
+	for(int r = 0; r < rounds; r++){
+		unsigned long start = nanotime();
+		pairhits = run(pairs_block, &projectiles, &aliens);
+		unsigned long middle = nanotime();
+		kernelhits = run(kernel_block, &projectiles, &aliens);
+		unsigned long end = nanotime();
+		if(middle - start < pairtime){
+			pairtime = middle - start;
+		}
+		if(end - middle < kerneltime){
+			kerneltime = end - middle;
+		}
+	}
+	double tests = (double)projectiles.count * aliens.count;
+	printf("pairs %.0f hits %ld\n", tests, pairhits);
+	printf("collides %.3fms %.2fns per pair\n", pairtime / 1e6, pairtime / tests);
+	printf("collide_block %.3fms %.2fns per pair hits %ld speedup %.1f\n", kerneltime / 1e6, kerneltime / tests, kernelhits, (double)pairtime / kerneltime);
+
+	entities_free(&projectiles);
+	entities_free(&aliens);
+	return 0;
+}
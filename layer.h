@@ -0,0 +1,114 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <stdio.h>
+#include <GL/glew.h>
+
+//an offscreen picture kept between frames, so a scene that barely changes is drawn into it
+//piece by piece and put on screen with one textured quad
+//
+//anything drawn between layer_begin and layer_end lands in the layer instead of the window,
+//with the same coordinates, as long as the layer is the window's size
+
+struct layer_s{
+	GLuint framebuffer;
+	GLuint texture;
+	int width;
+	int height;
+	//what was bound before layer_begin, put back by layer_end
+	GLint previous;
+	GLint viewport[4];
+};
+
+typedef struct layer_s layer_t;
+
+//returns 0 if the driver can't render to a texture
+inline int layer_create(layer_t* layer, int width, int height){
+	layer -> width = width;
+	layer -> height = height;
+
+	glGenTextures(1, &layer -> texture);
+	glBindTexture(GL_TEXTURE_2D, layer -> texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &layer -> framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, layer -> framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer -> texture, 0);
+	int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if(!complete){
+		printf("Failed to create render target\n");
+		glDeleteFramebuffers(1, &layer -> framebuffer);
+		glDeleteTextures(1, &layer -> texture);
+		return 0;
+	}
+	return 1;
+}
+
+inline void layer_free(layer_t* layer){
+	glDeleteFramebuffers(1, &layer -> framebuffer);
+	glDeleteTextures(1, &layer -> texture);
+}
+
+//send drawing to the layer
+inline void layer_begin(layer_t* layer){
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &layer -> previous);
+	glGetIntegerv(GL_VIEWPORT, layer -> viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, layer -> framebuffer);
+	glViewport(0, 0, layer -> width, layer -> height);
+}
+
+//send drawing back where it went before layer_begin
+inline void layer_end(layer_t* layer){
+	glBindFramebuffer(GL_FRAMEBUFFER, layer -> previous);
+	glViewport(layer -> viewport[0], layer -> viewport[1], layer -> viewport[2], layer -> viewport[3]);
+}
+
+//put the whole layer on the current target with its top left corner at x, y. it is copied as it
+//is, without blending, and the caller's matrices, program and texture are left as they were
+inline void layer_draw(const layer_t* layer, int x, int y){
+	GLint program;
+	GLint texture;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+	glUseProgram(0);
+	glDisable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, layer -> texture);
+	glColor4f(1, 1, 1, 1);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	//screen coordinates, y down like the rest of the drawing
+	glOrtho(0, viewport[2], viewport[3], 0, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	//the texture's bottom row is the bottom of what was drawn into it
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 1); glVertex2i(x, y);
+	glTexCoord2f(1, 1); glVertex2i(x + layer -> width, y);
+	glTexCoord2f(1, 0); glVertex2i(x + layer -> width, y + layer -> height);
+	glTexCoord2f(0, 0); glVertex2i(x, y + layer -> height);
+	glEnd();
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPopAttrib();
+	glUseProgram(program);
+}
+
+#endif
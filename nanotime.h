@@ -0,0 +1,16 @@
+#ifndef NANOTIME_H
+#define NANOTIME_H
+
+#include <time.h>
+
+//nanoseconds on a clock that only goes forward, for timing and pacing. only differences mean
+//anything
+inline unsigned long nanotime(){
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif
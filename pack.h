@@ -0,0 +1,120 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "image.h"
+
+//asset pack: images already decoded to RGBA at the size the games draw them, so startup maps one
+//file and hands the pixels to GL where they lie instead of decoding pngs
+//
+//layout: a header of magic and image count, an index of one entry per image (its name, the path
+//it was packed from, its size and where its pixels start), then the pixels, each image starting on
+//a PACK_ALIGN boundary. numbers are in the byte order of the machine that packed it, the pack is
+//built next to the games it's for. assetpack writes it
+
+const char PACK_MAGIC[8] = {'S', 'C', 'P', 'A', 'C', 'K', '0', '1'};
+const int PACK_NAME = 48;
+const int PACK_ALIGN = 64;
+
+struct packheader_s{
+	char magic[8];
+	uint32_t count;
+	uint32_t reserved;
+};
+
+typedef struct packheader_s packheader_t;
+
+struct packentry_s{
+	char name[PACK_NAME];
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;
+};
+
+typedef struct packentry_s packentry_t;
+
+struct pack_s{
+	const unsigned char* data;
+	size_t size;
+	const packentry_t* entries;
+	uint32_t count;
+};
+
+typedef struct pack_s pack_t;
+
+//map a pack, returns 0 if it's missing or isn't one
+inline int pack_open(pack_t* pack, const char* filename){
+	pack -> data = nullptr;
+	pack -> size = 0;
+	pack -> entries = nullptr;
+	pack -> count = 0;
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0){
+		return 0;
+	}
+	struct stat info;
+	if(fstat(fd, &info) || (size_t)info.st_size < sizeof(packheader_t)){
+		printf("Failed to read %s\n", filename);
+		close(fd);
+		return 0;
+	}
+	void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED){
+		printf("Failed to map %s\n", filename);
+		return 0;
+	}
+	const packheader_t* header = (const packheader_t*)data;
+	size_t indexend = sizeof(packheader_t) + (size_t)header -> count * sizeof(packentry_t);
+	int ok = !memcmp(header -> magic, PACK_MAGIC, sizeof(PACK_MAGIC)) && indexend <= (size_t)info.st_size;
+	const packentry_t* entries = (const packentry_t*)((const unsigned char*)data + sizeof(packheader_t));
+	for(uint32_t i = 0; ok && i < header -> count; i++){
+		ok = entries[i].offset + (uint64_t)entries[i].width * entries[i].height * 4 <= (uint64_t)info.st_size
+		  && memchr(entries[i].name, 0, PACK_NAME);
+	}
+	if(!ok){
+		printf("Failed to read %s\n", filename);
+		munmap(data, info.st_size);
+		return 0;
+	}
+	//everything is read once, front to back, as the assets are loaded
+	madvise(data, info.st_size, MADV_WILLNEED);
+	pack -> data = (const unsigned char*)data;
+	pack -> size = info.st_size;
+	pack -> entries = entries;
+	pack -> count = header -> count;
+	return 1;
+}
+
+inline void pack_close(pack_t* pack){
+	if(pack -> data){
+		munmap((void*)pack -> data, pack -> size);
+	}
+	pack -> data = nullptr;
+	pack -> size = 0;
+	pack -> entries = nullptr;
+	pack -> count = 0;
+}
+
+//point image at the packed pixels of name, returns 0 if it isn't in the pack. the pixels belong to
+//the mapping, so they're read only, never freed and gone after pack_close
+inline int pack_image(const pack_t* pack, const char* name, image_t* image){
+	//a pack holds a handful of images, a scan is as fast as anything cleverer
+	for(uint32_t i = 0; i < pack -> count; i++){
+		if(!strcmp(pack -> entries[i].name, name)){
+			image -> pixels = (unsigned char*)(pack -> data + pack -> entries[i].offset);
+			image -> width = pack -> entries[i].width;
+			image -> height = pack -> entries[i].height;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+#endif
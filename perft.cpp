@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "bitboard.h"
+#include "tt.h"
+#include "nanotime.h"
+
+//counts leaf nodes of the legal move tree, without a window
+//usage: perft [-t threads] [-H mb] [-d] depth [fen]    count nodes, -d prints the count under every root move
+//       perft [-t threads] [-H mb] -s [depth]          run the reference suite, up to depth (default 4)
+//-H caches subtree counts in a transposition table shared by all threads
+
+const char* startfen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+//positions with well known node counts, listed from depth 1
+struct reference_s{
+	const char* fen;
+	unsigned long long nodes[6];
+};
+
+typedef struct reference_s reference_t;
+
+const reference_t suite[] = {
+	{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", {20, 400, 8902, 197281, 4865609, 119060324}},
+	{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", {48, 2039, 97862, 4085603, 193690690, 0}},
+	{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624, 11030083}},
+	{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467, 422333, 15833292, 0}},
+	{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487, 89941194, 0}},
+	//rights the pieces don't back up, which have to count the same as without them
+	{"4k3/8/8/8/8/8/8/4K3 w K - 0 1", {5, 25, 170, 1156, 7922, 0}},
+	{"r3k3/8/8/8/8/8/8/R3K2R b KQkq - 0 1", {16, 362, 5628, 137142, 2167271, 0}},
+	{"4k3/8/8/4P3/8/8/8/4K3 w - d6 0 1", {6, 28, 212, 1250, 9648, 0}},
+	//and one en passant capture that is there
+	{"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", {7, 38, 276, 1786, 13207, 0}},
+};
+
+const int suitesize = sizeof(suite) / sizeof(suite[0]);
+
+//subtree counts by position and depth, unused unless -H is given
+tt_t perfthash;
+
+unsigned long long perft(position_t* pos, int depth){
+	movelist_t list;
+	unsigned long long nodes = 0;
+
+	movegen_legal(pos, &list);
+	//every generated move is legal, so the last ply is just the list length
+	if(depth == 1){
+		return list.count;
+	}
+	if(perfthash.count){
+		uint64_t cached;
+		int cached_depth;
+		if(tt_probe(&perfthash, pos -> key, &cached, &cached_depth) && cached_depth == depth){
+			return cached;
+		}
+	}
+	for(int i = 0; i < list.count; i++){
+		position_makemove(pos, list.moves[i]);
+		nodes += perft(pos, depth - 1);
+		position_unmakemove(pos);
+	}
+	if(perfthash.count){
+		tt_store(&perfthash, pos -> key, depth, nodes);
+	}
+	return nodes;
+}
+
+//root moves are handed out one at a time so threads stay busy until the last subtree
+struct split_s{
+	const position_t* pos;
+	movelist_t list;
+	unsigned long long nodes[MAX_MOVES];
+	int depth;
+	std::atomic<int> next;
+};
+
+typedef struct split_s split_t;
+
+void split_worker(split_t* split){
+	//each thread plays moves on its own copy
+	position_t pos = *split -> pos;
+	int i;
+	while((i = split -> next.fetch_add(1)) < split -> list.count){
+		position_makemove(&pos, split -> list.moves[i]);
+		split -> nodes[i] = split -> depth > 1 ? perft(&pos, split -> depth - 1) : 1;
+		position_unmakemove(&pos);
+	}
+}
+
+unsigned long long perft_split(const position_t* pos, int depth, int threads, int divide){
+	const int maxthreads = 256;
+	static split_t split;
+	std::thread workers[maxthreads];
+
+	if(depth < 1){
+		return 1;
+	}
+	if(threads > maxthreads){
+		threads = maxthreads;
+	}
+	split.pos = pos;
+	split.depth = depth;
+	split.next = 0;
+	movegen_legal(pos, &split.list);
+
+	for(int t = 1; t < threads; t++){
+		workers[t] = std::thread(split_worker, &split);
+	}
+	split_worker(&split);
+	for(int t = 1; t < threads; t++){
+		workers[t].join();
+	}
+
+	unsigned long long nodes = 0;
+	char name[6];
+	for(int i = 0; i < split.list.count; i++){
+		nodes += split.nodes[i];
+		if(divide){
+			move_tostring(split.list.moves[i], name);
+			printf("%s: %llu\n", name, split.nodes[i]);
+		}
+	}
+	return nodes;
+}
+
+//run one count and print it with the time it took, returns the node count
+unsigned long long perft_report(const position_t* pos, int depth, int threads, int divide){
+	unsigned long start = nanotime();
+	unsigned long long nodes = perft_split(pos, depth, threads, divide);
+	double seconds = (nanotime() - start) / 1e9;
+	if(seconds <= 0){
+		seconds = 1e-9;
+	}
+	printf("depth %d nodes %llu time %.3fs nps %.0f\n", depth, nodes, seconds, nodes / seconds);
+	return nodes;
+}
+
+int main(int argc, char** argv){
+	int threads = 1;
+	int divide = 0;
+	int runsuite = 0;
+	int depth = -1;
+	int hash_mb = 0;
+	const char* fen = startfen;
+
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-t") && i + 1 < argc){
+			threads = atoi(argv[++i]);
+		} else
+		if(!strcmp(argv[i], "-H") && i + 1 < argc){
+			hash_mb = atoi(argv[++i]);
+		} else
+		if(!strcmp(argv[i], "-d")){
+			divide = 1;
+		} else
+		if(!strcmp(argv[i], "-s")){
+			runsuite = 1;
+		} else
+		if(depth < 0){
+			depth = atoi(argv[i]);
+		} else{
+			fen = argv[i];
+		}
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+
+	attacks_init();
+	if(hash_mb > 0 && !tt_create(&perfthash, hash_mb)){
+		return -1;
+	}
+
+	position_t pos;
+	if(runsuite){
+		if(depth < 0){
+			depth = 4;
+		}
+		int failed = 0;
+		unsigned long long total = 0;
+		unsigned long start = nanotime();
+		for(int i = 0; i < suitesize; i++){
+			position_fromfen(&pos, suite[i].fen);
+			printf("%s\n", suite[i].fen);
+			for(int d = 1; d <= depth && d <= 6 && suite[i].nodes[d - 1]; d++){
+				unsigned long long nodes = perft_report(&pos, d, threads, 0);
+				total += nodes;
+				if(nodes != suite[i].nodes[d - 1]){
+					printf("MISMATCH expected %llu\n", suite[i].nodes[d - 1]);
+					failed++;
+				}
+			}
+		}
+		double seconds = (nanotime() - start) / 1e9;
+		printf("%s, %llu nodes in %.3fs, nps %.0f\n", failed ? "FAILED" : "all counts match", total, seconds, total / (seconds > 0 ? seconds : 1e-9));
+		return failed ? 1 : 0;
+	}
+
+	if(depth < 0){
+		printf("usage: perft [-t threads] [-H mb] [-d] depth [fen]\n       perft [-t threads] [-H mb] -s [depth]\n");
+		return -1;
+	}
+	if(!position_fromfen(&pos, fen)){
+		printf("Failed to parse fen\n");
+		return -1;
+	}
+	perft_report(&pos, depth, threads, divide);
+	return 0;
+}
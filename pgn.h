@@ -0,0 +1,505 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitboard.h"
+
+//standard algebraic notation and portable game notation, read straight out of a buffer
+//
+//a reader walks a block of text one game at a time and replays every move through the rules,
+//so a game only passes if each move is legal and unambiguous where it is played. it never
+//copies or allocates, the text can be a memory mapped file of any size
+
+const int PGN_END = 0;
+const int PGN_OK = 1;
+const int PGN_ERROR = -1;
+
+//how a game ended by its result token, from white's side
+const int PGN_UNKNOWN = 0;
+const int PGN_WHITEWIN = 1;
+const int PGN_BLACKWIN = 2;
+const int PGN_DRAW = 3;
+
+struct pgnreader_s{
+	//start of the block, the reader never looks before it
+	const char* text;
+	const char* p;
+	const char* end;
+	//plies replayed in the last game, and where in the text it stopped if it failed
+	int plies;
+	const char* error;
+	//result of the last game, and whether it started from a FEN tag
+	int result;
+	int fromfen;
+	//if set, the first maxmoves moves of each game are kept here
+	move_t* moves;
+	int maxmoves;
+};
+
+typedef struct pgnreader_s pgnreader_t;
+
+inline int san_piece(char c){
+	switch(c){
+		case 'N': return KNIGHT;
+		case 'B': return BISHOP;
+		case 'R': return ROOK;
+		case 'Q': return QUEEN;
+		case 'K': return KING;
+	}
+	return EMPTY;
+}
+
+//whether playing move leaves the mover's own king safe
+inline int san_legal(position_t* pos, move_t move){
+	int us = pos -> turn;
+	position_makemove(pos, move);
+	int legal = !square_attacked(pos, bitscan(pos -> pieces[KING][us]), !us);
+	position_unmakemove(pos);
+	return legal;
+}
+
+//the move written as san in this position, MOVE_NONE if it isn't legal or fits more than one.
+//only pieces that can reach the destination are tried, nothing else is generated
+inline move_t san_parse(position_t* pos, const char* san, int length){
+	int us = pos -> turn;
+
+	//check and annotation marks say nothing about the move
+	while(length > 0 && san[length - 1] && strchr("+#!?", san[length - 1])){
+		length--;
+	}
+
+	//castling, with letter O or digit 0
+	if(length >= 3 && (san[0] == 'O' || san[0] == '0')){
+		int backrank = us == WHITE ? 0 : 56;
+		int to = length >= 5 ? backrank + 2 : backrank + 6;
+		movelist_t list;
+		movegen_legal(pos, &list);
+		for(int i = 0; i < list.count; i++){
+			if(move_flag(list.moves[i]) == MOVE_CASTLE && move_to(list.moves[i]) == to){
+				return list.moves[i];
+			}
+		}
+		return MOVE_NONE;
+	}
+
+	int type = PAWN;
+	if(length && san_piece(san[0]) != EMPTY){
+		type = san_piece(san[0]);
+		san++;
+		length--;
+	}
+
+	//promotion piece at the end, e8=Q or e8Q
+	int promotion = EMPTY;
+	if(length && san_piece(san[length - 1]) != EMPTY){
+		promotion = san_piece(san[length - 1]);
+		length--;
+		if(length && san[length - 1] == '='){
+			length--;
+		}
+	}
+
+	//destination is the last square named, whatever is left before it narrows down the start
+	if(length < 2 || san[length - 2] < 'a' || san[length - 2] > 'h' || san[length - 1] < '1' || san[length - 1] > '8'){
+		return MOVE_NONE;
+	}
+	int to = square(san[length - 2] - 'a', san[length - 1] - '1');
+	int capture = 0;
+	bitboard_t from_mask = ~0ULL;
+	for(int i = 0; i < length - 2; i++){
+		if(san[i] >= 'a' && san[i] <= 'h'){
+			from_mask &= FILE_A << (san[i] - 'a');
+		} else
+		if(san[i] >= '1' && san[i] <= '8'){
+			from_mask &= RANK_1 << (8 * (san[i] - '1'));
+		} else
+		if(san[i] == 'x' || san[i] == ':'){
+			capture = 1;
+		} else
+		if(san[i] != '-'){
+			return MOVE_NONE;
+		}
+	}
+	if(pos -> colors[us] & bit(to)){
+		return MOVE_NONE;
+	}
+
+	bitboard_t candidates;
+	if(type != PAWN){
+		candidates = piece_attacks(type, us, to, pos -> occupied) & pos -> pieces[type][us];
+	} else
+	if(capture || from_mask != ~0ULL){
+		//a pawn capture always names the file it comes from
+		if(!(pos -> colors[!us] & bit(to)) && to != pos -> passant){
+			return MOVE_NONE;
+		}
+		candidates = pawn_attacks[!us][to] & pos -> pieces[PAWN][us];
+	} else{
+		//a push, one step or two from the starting rank over an empty square
+		if(pos -> occupied & bit(to)){
+			return MOVE_NONE;
+		}
+		int back = us == WHITE ? -8 : 8;
+		candidates = 0;
+		if(to + back >= 0 && to + back < 64){
+			if(pos -> pieces[PAWN][us] & bit(to + back)){
+				candidates = bit(to + back);
+			} else
+			if(!(pos -> occupied & bit(to + back)) && square_y(to) == (us == WHITE ? 3 : 4)){
+				candidates = pos -> pieces[PAWN][us] & bit(to + 2 * back);
+			}
+		}
+	}
+	candidates &= from_mask;
+
+	int promotes = type == PAWN && (square_y(to) == 0 || square_y(to) == 7);
+	if(promotes != (promotion != EMPTY) || promotion == KING){
+		return MOVE_NONE;
+	}
+	int flag = promotes ? MOVE_PROMOTION : (type == PAWN && to == pos -> passant) ? MOVE_PASSANT : MOVE_NORMAL;
+
+	move_t found = MOVE_NONE;
+	while(candidates){
+		move_t move = move_encode(poplsb(&candidates), to, flag, promotion);
+		if(san_legal(pos, move)){
+			if(found != MOVE_NONE){
+				return MOVE_NONE;
+			}
+			found = move;
+		}
+	}
+	return found;
+}
+
+//write a legal move in standard algebraic notation, out needs room for 8 chars
+inline void san_tostring(position_t* pos, move_t move, char* out){
+	int from = move_from(move);
+	int to = move_to(move);
+	int type = pos -> squares[from];
+	int capture = (pos -> occupied & bit(to)) || move_flag(move) == MOVE_PASSANT;
+
+	if(move_flag(move) == MOVE_CASTLE){
+		strcpy(out, square_x(to) == 6 ? "O-O" : "O-O-O");
+		out += strlen(out);
+	} else{
+		if(type != PAWN){
+			*out++ = "PBNRQK"[type];
+			//name the start file, rank or both when another piece of the type could go there too
+			movelist_t list;
+			movegen_legal(pos, &list);
+			int samefile = 0;
+			int samerank = 0;
+			int others = 0;
+			for(int i = 0; i < list.count; i++){
+				int other = move_from(list.moves[i]);
+				if(move_to(list.moves[i]) == to && other != from && pos -> squares[other] == type){
+					others++;
+					samefile |= square_x(other) == square_x(from);
+					samerank |= square_y(other) == square_y(from);
+				}
+			}
+			if(others && (!samefile || samerank)){
+				*out++ = 'a' + square_x(from);
+			}
+			if(others && samefile){
+				*out++ = '1' + square_y(from);
+			}
+		} else
+		if(capture){
+			*out++ = 'a' + square_x(from);
+		}
+		if(capture){
+			*out++ = 'x';
+		}
+		*out++ = 'a' + square_x(to);
+		*out++ = '1' + square_y(to);
+		if(move_flag(move) == MOVE_PROMOTION){
+			*out++ = '=';
+			*out++ = "PBNRQK"[move_promotion(move)];
+		}
+	}
+
+	position_makemove(pos, move);
+	if(position_incheck(pos)){
+		movelist_t replies;
+		movegen_legal(pos, &replies);
+		*out++ = replies.count ? '+' : '#';
+	}
+	position_unmakemove(pos);
+	*out = '\0';
+}
+
+inline void pgnreader_init(pgnreader_t* reader, const char* text, const char* end){
+	reader -> text = text;
+	reader -> p = text;
+	reader -> end = end;
+	reader -> plies = 0;
+	reader -> error = nullptr;
+	reader -> result = PGN_UNKNOWN;
+	reader -> fromfen = 0;
+	reader -> moves = nullptr;
+	reader -> maxmoves = 0;
+}
+
+inline int pgn_space(char c){
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+//whether p starts a line, which a tag has to for it to begin the next game
+inline int pgn_linestart(const pgnreader_t* reader, const char* p){
+	return p == reader -> text || p[-1] == '\n';
+}
+
+//skip to the start of the next game after a bad one, the first tag line after movetext
+inline void pgn_skipgame(pgnreader_t* reader, int inmoves){
+	while(reader -> p < reader -> end){
+		char c = *reader -> p;
+		if(c == '[' && inmoves && pgn_linestart(reader, reader -> p)){
+			return;
+		}
+		if(c == '['){
+			//a tag line, skip it whole
+			while(reader -> p < reader -> end && *reader -> p != '\n'){
+				reader -> p++;
+			}
+			continue;
+		}
+		if(!pgn_space(c)){
+			inmoves = 1;
+		}
+		reader -> p++;
+	}
+}
+
+//replay the next game into pos, starting from its FEN tag or the standard start.
+//returns PGN_END when the text runs out, else PGN_OK or PGN_ERROR with the reader past the game
+inline int pgn_nextgame(pgnreader_t* reader, position_t* pos){
+	const char* end = reader -> end;
+	const char* p = reader -> p;
+	reader -> plies = 0;
+	reader -> error = nullptr;
+	reader -> result = PGN_UNKNOWN;
+	reader -> fromfen = 0;
+
+	//tag pairs, only FEN changes how the game is replayed
+	position_start(pos);
+	int tags = 0;
+	for(;;){
+		while(p < end && pgn_space(*p)){
+			p++;
+		}
+		if(p >= end || *p != '['){
+			break;
+		}
+		tags++;
+		const char* name = ++p;
+		while(p < end && !pgn_space(*p) && *p != '"' && *p != ']'){
+			p++;
+		}
+		int namelength = (int)(p - name);
+		while(p < end && *p != '"' && *p != ']' && *p != '\n'){
+			p++;
+		}
+		const char* value = nullptr;
+		int valuelength = 0;
+		if(p < end && *p == '"'){
+			value = ++p;
+			while(p < end && *p != '"' && *p != '\n'){
+				p += *p == '\\' && p + 1 < end ? 2 : 1;
+			}
+			valuelength = (int)(p - value);
+		}
+		while(p < end && *p != '\n'){
+			p++;
+		}
+		if(namelength == 3 && !memcmp(name, "FEN", 3) && value){
+			char fen[FEN_MAX * 2];
+			if(valuelength >= (int)sizeof(fen)){
+				valuelength = sizeof(fen) - 1;
+			}
+			memcpy(fen, value, valuelength);
+			fen[valuelength] = '\0';
+			reader -> fromfen = 1;
+			if(!position_fromfen(pos, fen)){
+				reader -> error = name;
+				reader -> p = p;
+				pgn_skipgame(reader, 0);
+				return PGN_ERROR;
+			}
+		}
+	}
+
+	//movetext, up to the result or the next game's tags
+	int moves = 0;
+	for(;;){
+		while(p < end && pgn_space(*p)){
+			p++;
+		}
+		if(p >= end){
+			break;
+		}
+		char c = *p;
+		if(c == '[' && pgn_linestart(reader, p)){
+			break;
+		}
+		if(c == '{'){
+			while(p < end && *p != '}'){
+				p++;
+			}
+			p += p < end;
+			continue;
+		}
+		if(c == ';' || c == '%'){
+			while(p < end && *p != '\n'){
+				p++;
+			}
+			continue;
+		}
+		if(c == '('){
+			//variations are skipped, however deeply nested
+			int depth = 0;
+			for(; p < end; p++){
+				if(*p == '{'){
+					while(p < end && *p != '}'){
+						p++;
+					}
+				} else
+				if(*p == '('){
+					depth++;
+				} else
+				if(*p == ')' && !--depth){
+					p++;
+					break;
+				}
+			}
+			continue;
+		}
+		if(c == ')'){
+			p++;
+			continue;
+		}
+
+		const char* token = p;
+		while(p < end && !pgn_space(*p) && *p != '{' && *p != '(' && *p != ')' && *p != ';'){
+			p++;
+		}
+		int length = (int)(p - token);
+
+		if(c == '$'){
+			continue;
+		}
+		if((length == 3 && (!memcmp(token, "1-0", 3) || !memcmp(token, "0-1", 3)))
+		  || (length == 7 && !memcmp(token, "1/2-1/2", 7)) || (length == 1 && c == '*')){
+			if(length == 3){
+				reader -> result = token[0] == '1' ? PGN_WHITEWIN : PGN_BLACKWIN;
+			} else
+			if(length == 7){
+				reader -> result = PGN_DRAW;
+			}
+			reader -> p = p;
+			return PGN_OK;
+		}
+		//move numbers, 12. or 12... possibly glued to the move after them
+		if(c >= '0' && c <= '9' && !(length >= 3 && token[1] == '-')){
+			while(token < p && *token >= '0' && *token <= '9'){
+				token++;
+			}
+			while(token < p && *token == '.'){
+				token++;
+			}
+			length = (int)(p - token);
+			if(!length){
+				continue;
+			}
+		}
+		move_t move = san_parse(pos, token, length);
+		if(move == MOVE_NONE){
+			reader -> error = token;
+			reader -> p = p;
+			pgn_skipgame(reader, 1);
+			return PGN_ERROR;
+		}
+		if(pos -> ply >= MAX_HISTORY - 1){
+			position_trimhistory(pos, 128);
+		}
+		position_makemove(pos, move);
+		if(reader -> plies < reader -> maxmoves){
+			reader -> moves[reader -> plies] = move;
+		}
+		reader -> plies++;
+		moves = 1;
+	}
+
+	reader -> p = p;
+	return tags || moves ? PGN_OK : PGN_END;
+}
+
+//write a game as PGN, moves played from start, with a FEN tag if start isn't the standard one
+inline void pgn_write(FILE* file, const position_t* start, const move_t* moves, int count, const char* result){
+	position_t* pos = (position_t*)malloc(sizeof(position_t));
+	if(!pos){
+		printf("Failed to allocate memory\n");
+		return;
+	}
+	char fen[FEN_MAX];
+	position_t standard;
+	position_start(&standard);
+	fprintf(file, "[Event \"?\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"?\"]\n[White \"?\"]\n[Black \"?\"]\n[Result \"%s\"]\n", result);
+	if(start -> key != standard.key){
+		position_tofen(start, fen);
+		fprintf(file, "[SetUp \"1\"]\n[FEN \"%s\"]\n", fen);
+	}
+	fprintf(file, "\n");
+
+	*pos = *start;
+	pos -> ply = 0;
+	int column = 0;
+	char word[16];
+	for(int i = 0; i < count; i++){
+		char san[8];
+		san_tostring(pos, moves[i], san);
+		if(pos -> turn == WHITE){
+			snprintf(word, sizeof(word), "%d. %s", pos -> fullmove, san);
+		} else
+		if(!i){
+			snprintf(word, sizeof(word), "%d... %s", pos -> fullmove, san);
+		} else{
+			snprintf(word, sizeof(word), "%s", san);
+		}
+		//keep lines under 80 characters, as the export format asks
+		if(column && column + 1 + (int)strlen(word) >= 80){
+			fprintf(file, "\n");
+			column = 0;
+		}
+		column += fprintf(file, "%s%s", column ? " " : "", word);
+		if(pos -> ply >= MAX_HISTORY - 1){
+			position_trimhistory(pos, 128);
+		}
+		position_makemove(pos, moves[i]);
+	}
+	fprintf(file, "%s%s\n\n", column ? " " : "", result);
+	free(pos);
+}
+
+//offset of the first game starting at or after from, found by a tag line following a blank line
+inline const char* pgn_findgame(const char* text, const char* from, const char* end){
+	if(from <= text){
+		return text;
+	}
+	for(const char* p = from; p < end; p++){
+		if(*p == '[' && p[-1] == '\n'){
+			const char* before = p - 2;
+			if(before >= text && *before == '\r'){
+				before--;
+			}
+			if(before < text || *before == '\n'){
+				return p;
+			}
+		}
+	}
+	return end;
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include "bitboard.h"
+#include "pgn.h"
+#include "nanotime.h"
+
+//replays every game of PGN archives through the rules and reports the ones that don't hold up
+//usage: pgncheck [-t threads] file...
+//files are memory mapped and split at game boundaries, each thread replays its own share
+
+//errors each thread remembers the position of, the rest are only counted
+const int MAX_REPORTED = 16;
+
+struct chunk_s{
+	const char* start;
+	const char* end;
+	unsigned long long games;
+	unsigned long long plies;
+	unsigned long long errors;
+	const char* reported[MAX_REPORTED];
+};
+
+typedef struct chunk_s chunk_t;
+
+void chunk_check(chunk_t* chunk){
+	//positions carry a long undo history, too big for a thread's stack to hold comfortably
+	position_t* pos = (position_t*)malloc(sizeof(position_t));
+	if(!pos){
+		printf("Failed to allocate memory\n");
+		return;
+	}
+	pgnreader_t reader;
+	pgnreader_init(&reader, chunk -> start, chunk -> end);
+	int result;
+	while((result = pgn_nextgame(&reader, pos)) != PGN_END){
+		chunk -> games++;
+		chunk -> plies += reader.plies;
+		if(result == PGN_ERROR){
+			if(chunk -> errors < MAX_REPORTED){
+				chunk -> reported[chunk -> errors] = reader.error;
+			}
+			chunk -> errors++;
+		}
+	}
+	free(pos);
+}
+
+//print where in the file a bad game went wrong, by line and the token it choked on
+void report_error(const char* name, const char* text, const char* end, const char* error){
+	int line = 1;
+	for(const char* p = text; p < error; p++){
+		line += *p == '\n';
+	}
+	int length = 0;
+	while(error + length < end && error[length] != '\n' && error[length] != ' ' && length < 16){
+		length++;
+	}
+	printf("%s:%d: bad move or tag \"%.*s\"\n", name, line, length, error);
+}
+
+int main(int argc, char** argv){
+	int threads = std::thread::hardware_concurrency();
+	int first = 1;
+	if(argc > 2 && !strcmp(argv[1], "-t")){
+		threads = atoi(argv[2]);
+		first = 3;
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+	if(first >= argc){
+		printf("usage: pgncheck [-t threads] file...\n");
+		return -1;
+	}
+
+	attacks_init();
+
+	chunk_t* chunks = (chunk_t*)calloc(threads, sizeof(chunk_t));
+	std::thread* workers = new std::thread[threads];
+	if(!chunks){
+		printf("Failed to allocate memory\n");
+		return -1;
+	}
+
+	unsigned long long games = 0, plies = 0, errors = 0, bytes = 0;
+	unsigned long start = nanotime();
+	for(int f = first; f < argc; f++){
+		int fd = open(argv[f], O_RDONLY);
+		if(fd < 0){
+			printf("Failed to open %s\n", argv[f]);
+			return -1;
+		}
+		struct stat info;
+		fstat(fd, &info);
+		size_t size = info.st_size;
+		if(!size){
+			close(fd);
+			continue;
+		}
+		const char* text = (const char*)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(text == MAP_FAILED){
+			printf("Failed to map %s\n", argv[f]);
+			return -1;
+		}
+		madvise((void*)text, size, MADV_SEQUENTIAL);
+		const char* end = text + size;
+
+		//equal shares of the file, each moved up to the next game so no game is split
+		for(int t = 0; t < threads; t++){
+			memset(&chunks[t], 0, sizeof(chunk_t));
+			chunks[t].start = pgn_findgame(text, text + size / threads * t, end);
+		}
+		for(int t = 0; t < threads; t++){
+			chunks[t].end = t + 1 < threads ? chunks[t + 1].start : end;
+		}
+		for(int t = 1; t < threads; t++){
+			workers[t] = std::thread(chunk_check, &chunks[t]);
+		}
+		chunk_check(&chunks[0]);
+		for(int t = 1; t < threads; t++){
+			workers[t].join();
+		}
+
+		for(int t = 0; t < threads; t++){
+			for(unsigned long long i = 0; i < chunks[t].errors && i < MAX_REPORTED; i++){
+				report_error(argv[f], text, end, chunks[t].reported[i]);
+			}
+			games += chunks[t].games;
+			plies += chunks[t].plies;
+			errors += chunks[t].errors;
+		}
+		bytes += size;
+		munmap((void*)text, size);
+	}
+
+	double seconds = (nanotime() - start) / 1e9;
+	if(seconds <= 0){
+		seconds = 1e-9;
+	}
+	printf("games %llu errors %llu plies %llu time %.3fs games/sec %.0f MB/s %.1f\n", games, errors, plies, seconds, games / seconds, bytes / seconds / 1e6);
+
+	delete[] workers;
+	free(chunks);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+
+//recordings of space invaders games, enough to play them again exactly
+//
+//a game is its seed, its size and the keys held each tick, so that's all a recording keeps, plus
+//hashes of the game now and then to check a replay against. layout: a header of magic, seed,
+//width and height in the byte order of the machine that recorded it, then records of one tag byte
+//each:
+//  keys (0 to 31)  the keys held, then how many ticks in a row they were held
+//  REPLAY_HASH     the tick number then game_hash after that tick, every REPLAY_INTERVAL ticks
+//  REPLAY_END      the tick number then game_hash once the recording stopped
+//counts and tick numbers are varints, 7 bits a byte, low bits first. keys change a few times a
+//second at most, so a minute of play is a few hundred bytes
+
+const char REPLAY_MAGIC[8] = {'S', 'C', 'R', 'P', 'L', 'Y', '0', '1'};
+const int REPLAY_INTERVAL = 60;
+const int REPLAY_HASH = 0xFE;
+const int REPLAY_END = 0xFF;
+
+//what replay_input returns instead of keys
+const int REPLAY_OVER = -1;
+const int REPLAY_DIVERGED = -2;
+
+struct replayheader_s{
+	char magic[8];
+	uint64_t seed;
+	int32_t width;
+	int32_t height;
+};
+
+typedef struct replayheader_s replayheader_t;
+
+struct recorder_s{
+	FILE* file;
+	//keys held and for how many ticks, not written until they change
+	int input;
+	long run;
+};
+
+typedef struct recorder_s recorder_t;
+
+struct replay_s{
+	unsigned char* data;
+	size_t size;
+	size_t at;
+	unsigned long seed;
+	int width;
+	int height;
+	int input;
+	long run;
+};
+
+typedef struct replay_s replay_t;
+
+inline void recorder_varint(recorder_t* recorder, uint64_t v){
+	while(v >= 0x80){
+		fputc((int)(v & 0x7F) | 0x80, recorder -> file);
+		v >>= 7;
+	}
+	fputc((int)v, recorder -> file);
+}
+
+inline void recorder_hash(recorder_t* recorder, int tag, const game_t* game){
+	uint64_t hash = game_hash(game);
+	fputc(tag, recorder -> file);
+	recorder_varint(recorder, game -> ticks);
+	fwrite(&hash, sizeof(hash), 1, recorder -> file);
+}
+
+inline void recorder_flush(recorder_t* recorder){
+	if(recorder -> run){
+		fputc(recorder -> input, recorder -> file);
+		recorder_varint(recorder, recorder -> run);
+		recorder -> run = 0;
+	}
+}
+
+//start recording a game just created by game_create, returns 0 on failure
+inline int recorder_open(recorder_t* recorder, const char* filename, const game_t* game, unsigned long seed){
+	recorder -> file = fopen(filename, "wb");
+	recorder -> input = 0;
+	recorder -> run = 0;
+	if(!recorder -> file){
+		printf("Failed to open %s\n", filename);
+		return 0;
+	}
+	replayheader_t header;
+	memcpy(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+	header.seed = seed;
+	header.width = game -> width;
+	header.height = game -> height;
+	fwrite(&header, sizeof(header), 1, recorder -> file);
+	return 1;
+}
+
+//record the keys of the tick game has just played
+inline void recorder_tick(recorder_t* recorder, const game_t* game, int input){
+	if(recorder -> run && input != recorder -> input){
+		recorder_flush(recorder);
+	}
+	recorder -> input = input;
+	recorder -> run++;
+	if(game -> ticks % REPLAY_INTERVAL == 0){
+		recorder_flush(recorder);
+		recorder_hash(recorder, REPLAY_HASH, game);
+	}
+}
+
+//end the recording where game is now, returns 0 if it couldn't all be written
+inline int recorder_close(recorder_t* recorder, const game_t* game){
+	recorder_flush(recorder);
+	recorder_hash(recorder, REPLAY_END, game);
+	int ok = !ferror(recorder -> file);
+	if(fclose(recorder -> file)){
+		ok = 0;
+	}
+	recorder -> file = nullptr;
+	if(!ok){
+		printf("Failed to write recording\n");
+	}
+	return ok;
+}
+
+//read a recording, returns 0 if it's missing or isn't one. the game to play it on is created with
+//the seed, width and height it leaves in replay
+inline int replay_open(replay_t* replay, const char* filename){
+	replay -> data = nullptr;
+	replay -> size = 0;
+	replay -> at = sizeof(replayheader_t);
+	replay -> input = 0;
+	replay -> run = 0;
+	FILE* file = fopen(filename, "rb");
+	if(!file){
+		printf("Failed to open %s\n", filename);
+		return 0;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if(size < (long)sizeof(replayheader_t)){
+		printf("Failed to read %s\n", filename);
+		fclose(file);
+		return 0;
+	}
+	replay -> data = (unsigned char*)malloc(size);
+	if(!replay -> data || fread(replay -> data, 1, size, file) != (size_t)size){
+		printf("Failed to read %s\n", filename);
+		free(replay -> data);
+		replay -> data = nullptr;
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+	replayheader_t header;
+	memcpy(&header, replay -> data, sizeof(header));
+	if(memcmp(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC))){
+		printf("Failed to read %s, not a recording\n", filename);
+		free(replay -> data);
+		replay -> data = nullptr;
+		return 0;
+	}
+	replay -> size = size;
+	replay -> seed = header.seed;
+	replay -> width = header.width;
+	replay -> height = header.height;
+	return 1;
+}
+
+inline void replay_close(replay_t* replay){
+	free(replay -> data);
+	replay -> data = nullptr;
+	replay -> size = 0;
+}
+
+//back to the start, to play it again on a new game
+inline void replay_rewind(replay_t* replay){
+	replay -> at = sizeof(replayheader_t);
+	replay -> input = 0;
+	replay -> run = 0;
+}
+
+//returns 0 if the recording ends partway
+inline int replay_varint(replay_t* replay, uint64_t* v){
+	*v = 0;
+	for(int shift = 0; shift < 64; shift += 7){
+		if(replay -> at == replay -> size){
+			return 0;
+		}
+		unsigned char byte = replay -> data[replay -> at++];
+		*v |= (uint64_t)(byte & 0x7F) << shift;
+		if(!(byte & 0x80)){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+//returns 0 if game isn't where the recording says it was at that tick
+inline int replay_check(replay_t* replay, const game_t* game){
+	uint64_t tick;
+	uint64_t hash;
+	if(!replay_varint(replay, &tick) || replay -> size - replay -> at < sizeof(hash)){
+		printf("Recording ends partway\n");
+		return 0;
+	}
+	memcpy(&hash, replay -> data + replay -> at, sizeof(hash));
+	replay -> at += sizeof(hash);
+	if((long)tick != game -> ticks || hash != game_hash(game)){
+		printf("Replay diverged at tick %ld, recorded tick %lu\n", game -> ticks, (unsigned long)tick);
+		return 0;
+	}
+	return 1;
+}
+
+//keys for the next tick of game, REPLAY_OVER once the recording is played and game ended where it
+//did, REPLAY_DIVERGED if game went somewhere else or the recording is broken
+inline int replay_input(replay_t* replay, const game_t* game){
+	while(!replay -> run){
+		if(replay -> at == replay -> size){
+			printf("Recording ends partway\n");
+			return REPLAY_DIVERGED;
+		}
+		int tag = replay -> data[replay -> at++];
+		if(tag == REPLAY_HASH || tag == REPLAY_END){
+			if(!replay_check(replay, game)){
+				return REPLAY_DIVERGED;
+			}
+			if(tag == REPLAY_END){
+				return REPLAY_OVER;
+			}
+		} else if(tag < 32){
+			uint64_t run;
+			if(!replay_varint(replay, &run) || !run){
+				printf("Recording ends partway\n");
+				return REPLAY_DIVERGED;
+			}
+			replay -> input = tag;
+			replay -> run = run;
+		} else{
+			printf("Failed to read recording, unknown record %d\n", tag);
+			return REPLAY_DIVERGED;
+		}
+	}
+	replay -> run--;
+	return replay -> input;
+}
+
+#endif
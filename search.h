@@ -0,0 +1,588 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <atomic>
+#include <thread>
+#include "bitboard.h"
+#include "tt.h"
+#include "bitbase.h"
+#include "nanotime.h"
+
+//alpha-beta search for the side to move: iterative deepening, principal variation search,
+//quiescence on captures, and moves ordered by hash move, MVV-LVA, killers and history.
+//several threads can search the same position at once, lazy smp style, talking to each
+//other only through the shared transposition table
+
+const int SCORE_INF = 32000;
+//mate in n plies scores SCORE_MATE - n, anything beyond SCORE_MATE - MAX_PLY is a mate
+const int SCORE_MATE = 31000;
+//won endgames from the bitbases, above any material but clear of the mate scores
+const int SCORE_KNOWNWIN = 20000;
+const int MAX_PLY = 128;
+const int MAX_THREADS = 256;
+
+//bound kinds stored with a hashed score
+const int BOUND_EXACT = 0;
+const int BOUND_LOWER = 1;
+const int BOUND_UPPER = 2;
+
+const int piece_value[6] = {100, 330, 320, 500, 900, 0};
+
+//piece-square bonuses from white's side, rank 8 on the first row
+const int piece_square[6][64] = {
+	{
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		 50,  50,  50,  50,  50,  50,  50,  50,
+		 10,  10,  20,  30,  30,  20,  10,  10,
+		  5,   5,  10,  25,  25,  10,   5,   5,
+		  0,   0,   0,  20,  20,   0,   0,   0,
+		  5,  -5, -10,   0,   0, -10,  -5,   5,
+		  5,  10,  10, -20, -20,  10,  10,   5,
+		  0,   0,   0,   0,   0,   0,   0,   0
+	},
+	{
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,  10,  10,   5,   0, -10,
+		-10,   5,   5,  10,  10,   5,   5, -10,
+		-10,   0,  10,  10,  10,  10,   0, -10,
+		-10,  10,  10,  10,  10,  10,  10, -10,
+		-10,   5,   0,   0,   0,   0,   5, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20
+	},
+	{
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20,   0,   0,   0,   0, -20, -40,
+		-30,   0,  10,  15,  15,  10,   0, -30,
+		-30,   5,  15,  20,  20,  15,   5, -30,
+		-30,   0,  15,  20,  20,  15,   0, -30,
+		-30,   5,  10,  15,  15,  10,   5, -30,
+		-40, -20,   0,   5,   5,   0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50
+	},
+	{
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  5,  10,  10,  10,  10,  10,  10,   5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		  0,   0,   0,   5,   5,   0,   0,   0
+	},
+	{
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		  0,   0,   5,   5,   5,   5,   0,  -5,
+		-10,   5,   5,   5,   5,   5,   0, -10,
+		-10,   0,   5,   0,   0,   0,   0, -10,
+		-20, -10, -10,  -5,  -5, -10, -10, -20
+	},
+	{
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-20, -30, -30, -40, -40, -30, -30, -20,
+		-10, -20, -20, -20, -20, -20, -20, -10,
+		 20,  20,   0,   0,   0,   0,  20,  20,
+		 20,  30,  10,   0,   0,  10,  30,  20
+	}
+};
+
+//the king walks to the middle once the pieces are gone
+const int king_endgame[64] = {
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50
+};
+
+//material and piece placement, from the side to move's point of view
+inline int evaluate(const position_t* pos){
+	int score[2] = {0, 0};
+	int king[2] = {0, 0};
+	//24 with every piece on the board, 0 with only kings and pawns
+	int phase = 0;
+	for(int color = BLACK; color <= WHITE; color++){
+		//tables are drawn from white's side, flip the rank for white
+		int flip = color == WHITE ? 56 : 0;
+		for(int type = PAWN; type < KING; type++){
+			bitboard_t pieces = pos -> pieces[type][color];
+			while(pieces){
+				int sq = poplsb(&pieces);
+				score[color] += piece_value[type] + piece_square[type][sq ^ flip];
+			}
+		}
+		phase += popcount(pos -> pieces[KNIGHT][color] | pos -> pieces[BISHOP][color]);
+		phase += 2 * popcount(pos -> pieces[ROOK][color]) + 4 * popcount(pos -> pieces[QUEEN][color]);
+		king[color] = bitscan(pos -> pieces[KING][color]) ^ flip;
+	}
+	if(phase > 24){
+		phase = 24;
+	}
+	for(int color = BLACK; color <= WHITE; color++){
+		score[color] += (piece_square[KING][king[color]] * phase + king_endgame[king[color]] * (24 - phase)) / 24;
+	}
+	return score[pos -> turn] - score[!pos -> turn];
+}
+
+//score for a bitbase result from the side to move's point of view. a won position is worth more than any
+//material but still rewards progress, the pawn running on or the bare king driven to the edge with
+//the strong king close by, so the search heads somewhere instead of picking any won move
+inline int evaluate_known(const position_t* pos, int outcome){
+	if(outcome == BITBASE_DRAW){
+		return 0;
+	}
+	int strong = outcome == BITBASE_WIN ? pos -> turn : !pos -> turn;
+	int strongking = bitscan(pos -> pieces[KING][strong]);
+	int weakking = bitscan(pos -> pieces[KING][!strong]);
+	int progress;
+	if(pos -> pieces[PAWN][strong]){
+		int pawn = bitscan(pos -> pieces[PAWN][strong]);
+		progress = 20 * (strong == WHITE ? square_y(pawn) : 7 - square_y(pawn));
+	} else{
+		int dx = square_x(strongking) - square_x(weakking);
+		int dy = square_y(strongking) - square_y(weakking);
+		progress = -king_endgame[weakking] + 10 * (14 - (dx < 0 ? -dx : dx) - (dy < 0 ? -dy : dy));
+	}
+	return outcome == BITBASE_WIN ? SCORE_KNOWNWIN + progress : -SCORE_KNOWNWIN - progress;
+}
+
+//0 for no limit
+struct searchlimits_s{
+	int depth;
+	//milliseconds
+	int movetime;
+	uint64_t nodes;
+	//set to search until told to stop, the answer waits even if the search ends sooner
+	int infinite;
+};
+
+typedef struct searchlimits_s searchlimits_t;
+
+struct searcher_s;
+
+//state every thread of one search shares
+struct searchshared_s{
+	tt_t* tt;
+	//set by anyone to end the search early, checked every thousand or so nodes
+	std::atomic<int> stop;
+	//nodes searched by all threads together, added to in batches
+	std::atomic<uint64_t> nodes;
+	//clock time the search has to end by, 0 for none
+	std::atomic<unsigned long> deadline;
+	//set while searching on the opponent's time, the clock only starts once it's cleared
+	std::atomic<int> ponder;
+	//clock time the search started at
+	unsigned long start;
+	//called by the main thread after every finished iteration, if set
+	void (*report)(const searcher_s* s);
+};
+
+typedef struct searchshared_s searchshared_t;
+
+//everything one search thread owns
+struct searcher_s{
+	position_t pos;
+	searchshared_t* shared;
+	//0 for the main thread, which decides when the search ends
+	int id;
+	uint64_t nodelimit;
+	//nodes searched by this thread alone
+	uint64_t nodes;
+	//the root is itself in the bitbases, so probes only score leaves instead of ending the search
+	int rootknown;
+	move_t killers[MAX_PLY][2];
+	int history[2][64][64];
+	//triangular principal variation, pv[ply] holds the best line from ply on
+	move_t pv[MAX_PLY][MAX_PLY];
+	int pvlength[MAX_PLY];
+	//result of the last finished iteration, with the reply it expects
+	move_t bestmove;
+	move_t pondermove;
+	int bestscore;
+	int depth;
+};
+
+typedef struct searcher_s searcher_t;
+
+inline unsigned long search_clock(){
+	return nanotime();
+}
+
+inline void searchshared_init(searchshared_t* shared, tt_t* tt){
+	shared -> tt = tt;
+	shared -> stop = 0;
+	shared -> nodes = 0;
+	shared -> deadline = 0;
+	shared -> ponder = 0;
+	shared -> start = 0;
+	shared -> report = nullptr;
+}
+
+inline void searcher_init(searcher_t* s, const position_t* pos, searchshared_t* shared){
+	s -> pos = *pos;
+	s -> shared = shared;
+	s -> id = 0;
+	s -> nodelimit = 0;
+	s -> nodes = 0;
+	s -> rootknown = 0;
+	for(int ply = 0; ply < MAX_PLY; ply++){
+		s -> killers[ply][0] = MOVE_NONE;
+		s -> killers[ply][1] = MOVE_NONE;
+		s -> pvlength[ply] = 0;
+	}
+	for(int color = BLACK; color <= WHITE; color++){
+		for(int from = 0; from < 64; from++){
+			for(int to = 0; to < 64; to++){
+				s -> history[color][from][to] = 0;
+			}
+		}
+	}
+	s -> bestmove = MOVE_NONE;
+	s -> pondermove = MOVE_NONE;
+	s -> bestscore = 0;
+	s -> depth = 0;
+}
+
+//mate scores are stored relative to the node so they stay right when found at another ply
+inline int score_tohash(int score, int ply){
+	if(score > SCORE_MATE - MAX_PLY) return score + ply;
+	if(score < -SCORE_MATE + MAX_PLY) return score - ply;
+	return score;
+}
+
+inline int score_fromhash(int score, int ply){
+	if(score > SCORE_MATE - MAX_PLY) return score - ply;
+	if(score < -SCORE_MATE + MAX_PLY) return score + ply;
+	return score;
+}
+
+//hash payload: move in bits 0-15, score in 16-31, bound in 32-33
+inline uint64_t hash_pack(move_t move, int score, int bound){
+	return (uint64_t)move | ((uint64_t)(uint16_t)(int16_t)score << 16) | ((uint64_t)bound << 32);
+}
+
+inline int search_capture(const position_t* pos, move_t move){
+	return pos -> squares[move_to(move)] != EMPTY || move_flag(move) == MOVE_PASSANT;
+}
+
+//order key of every move, higher is searched first
+inline void search_scoremoves(const searcher_t* s, const movelist_t* list, int* scores, move_t hashmove, int ply){
+	const position_t* pos = &s -> pos;
+	for(int i = 0; i < list -> count; i++){
+		move_t move = list -> moves[i];
+		if(move == hashmove){
+			scores[i] = 1 << 30;
+		} else
+		if(search_capture(pos, move)){
+			//most valuable victim first, least valuable attacker breaking ties
+			int victim = move_flag(move) == MOVE_PASSANT ? PAWN : pos -> squares[move_to(move)];
+			scores[i] = (1 << 24) + 16 * piece_value[victim] - piece_value[pos -> squares[move_from(move)]] / 10;
+		} else
+		if(move_flag(move) == MOVE_PROMOTION){
+			scores[i] = (1 << 23) + piece_value[move_promotion(move)];
+		} else
+		if(move == s -> killers[ply][0]){
+			scores[i] = (1 << 22) + 1;
+		} else
+		if(move == s -> killers[ply][1]){
+			scores[i] = 1 << 22;
+		} else{
+			scores[i] = s -> history[pos -> turn][move_from(move)][move_to(move)];
+		}
+	}
+}
+
+//swap the best scored move left into slot i
+inline move_t search_pickmove(movelist_t* list, int* scores, int i){
+	int best = i;
+	for(int j = i + 1; j < list -> count; j++){
+		if(scores[j] > scores[best]){
+			best = j;
+		}
+	}
+	move_t move = list -> moves[best];
+	int score = scores[best];
+	list -> moves[best] = list -> moves[i];
+	scores[best] = scores[i];
+	list -> moves[i] = move;
+	scores[i] = score;
+	return move;
+}
+
+//count a node and raise the stop flag once time or nodes run out
+inline int search_tick(searcher_t* s){
+	s -> nodes++;
+	if(!(s -> nodes & 1023)){
+		uint64_t total = s -> shared -> nodes.fetch_add(1024, std::memory_order_relaxed) + 1024;
+		unsigned long deadline = s -> shared -> deadline.load(std::memory_order_relaxed);
+		if(s -> depth > 0 && ((deadline && search_clock() >= deadline) || (s -> nodelimit && total >= s -> nodelimit))){
+			s -> shared -> stop.store(1, std::memory_order_relaxed);
+		}
+	}
+	return s -> shared -> stop.load(std::memory_order_relaxed);
+}
+
+//only captures and promotions, until the position is quiet
+inline int search_quiesce(searcher_t* s, int alpha, int beta, int ply){
+	position_t* pos = &s -> pos;
+	if(search_tick(s)){
+		return 0;
+	}
+	int outcome;
+	int known = bitbase_probe(pos, &outcome);
+	if(known && !s -> rootknown){
+		return evaluate_known(pos, outcome);
+	}
+	int stand = known ? evaluate_known(pos, outcome) : evaluate(pos);
+	if(stand >= beta || ply >= MAX_PLY - 1){
+		return stand;
+	}
+	if(stand > alpha){
+		alpha = stand;
+	}
+
+	movelist_t list;
+	int scores[MAX_MOVES];
+	movegen_legal(pos, &list);
+	//keep the tactical moves only
+	int count = 0;
+	for(int i = 0; i < list.count; i++){
+		move_t move = list.moves[i];
+		if(search_capture(pos, move) || (move_flag(move) == MOVE_PROMOTION && move_promotion(move) == QUEEN)){
+			list.moves[count++] = move;
+		}
+	}
+	list.count = count;
+	search_scoremoves(s, &list, scores, MOVE_NONE, ply);
+
+	for(int i = 0; i < list.count; i++){
+		move_t move = search_pickmove(&list, scores, i);
+		position_makemove(pos, move);
+		int score = -search_quiesce(s, -beta, -alpha, ply + 1);
+		position_unmakemove(pos);
+		if(s -> shared -> stop.load(std::memory_order_relaxed)){
+			return 0;
+		}
+		if(score >= beta){
+			return score;
+		}
+		if(score > alpha){
+			alpha = score;
+		}
+	}
+	return alpha;
+}
+
+inline int search_node(searcher_t* s, int alpha, int beta, int depth, int ply){
+	position_t* pos = &s -> pos;
+	s -> pvlength[ply] = ply;
+
+	if(ply > 0 && (pos -> halfmove >= 100 || position_repetitions(pos) || position_insufficient(pos))){
+		return 0;
+	}
+	//endgames in the bitbases are scored outright, unless the game is already in one and the search
+	//has to find the way to mate
+	int outcome;
+	if(ply > 0 && !s -> rootknown && bitbase_probe(pos, &outcome)){
+		return evaluate_known(pos, outcome);
+	}
+	int incheck = position_incheck(pos);
+	//look one ply further when in check so forced lines aren't cut short
+	if(incheck){
+		depth++;
+	}
+	if(depth <= 0){
+		return search_quiesce(s, alpha, beta, ply);
+	}
+	if(search_tick(s)){
+		return 0;
+	}
+	if(ply >= MAX_PLY - 1){
+		return evaluate(pos);
+	}
+
+	//hash move and cutoff
+	move_t hashmove = MOVE_NONE;
+	uint64_t payload;
+	int hashdepth;
+	if(tt_probe(s -> shared -> tt, pos -> key, &payload, &hashdepth)){
+		hashmove = (move_t)(payload & 0xFFFF);
+		int score = score_fromhash((int16_t)(uint16_t)(payload >> 16), ply);
+		int bound = (payload >> 32) & 3;
+		if(ply > 0 && hashdepth >= depth && beta - alpha == 1){
+			if(bound == BOUND_EXACT || (bound == BOUND_LOWER && score >= beta) || (bound == BOUND_UPPER && score <= alpha)){
+				return score;
+			}
+		}
+	}
+
+	movelist_t list;
+	int scores[MAX_MOVES];
+	movegen_legal(pos, &list);
+	if(!list.count){
+		return incheck ? -SCORE_MATE + ply : 0;
+	}
+	search_scoremoves(s, &list, scores, hashmove, ply);
+
+	int oldalpha = alpha;
+	int best = -SCORE_INF;
+	move_t bestmove = MOVE_NONE;
+	for(int i = 0; i < list.count; i++){
+		move_t move = search_pickmove(&list, scores, i);
+		int quiet = !search_capture(pos, move) && move_flag(move) != MOVE_PROMOTION;
+		int score;
+
+		position_makemove(pos, move);
+		tt_prefetch(s -> shared -> tt, pos -> key);
+		if(i == 0){
+			score = -search_node(s, -beta, -alpha, depth - 1, ply + 1);
+		} else{
+			//prove the move is no better with a null window, search it fully only if it is
+			score = -search_node(s, -alpha - 1, -alpha, depth - 1, ply + 1);
+			if(score > alpha && score < beta){
+				score = -search_node(s, -beta, -alpha, depth - 1, ply + 1);
+			}
+		}
+		position_unmakemove(pos);
+
+		if(s -> shared -> stop.load(std::memory_order_relaxed)){
+			return 0;
+		}
+		if(score > best){
+			best = score;
+			bestmove = move;
+			if(score > alpha){
+				alpha = score;
+				//this move followed by the child's line is the new principal variation
+				s -> pv[ply][ply] = move;
+				for(int j = ply + 1; j < s -> pvlength[ply + 1]; j++){
+					s -> pv[ply][j] = s -> pv[ply + 1][j];
+				}
+				s -> pvlength[ply] = s -> pvlength[ply + 1] > ply + 1 ? s -> pvlength[ply + 1] : ply + 1;
+				if(alpha >= beta){
+					if(quiet){
+						if(s -> killers[ply][0] != move){
+							s -> killers[ply][1] = s -> killers[ply][0];
+							s -> killers[ply][0] = move;
+						}
+						int* history = &s -> history[pos -> turn][move_from(move)][move_to(move)];
+						*history += depth * depth;
+						//keep history below the killer scores
+						if(*history > (1 << 21)){
+							for(int from = 0; from < 64; from++){
+								for(int to = 0; to < 64; to++){
+									s -> history[pos -> turn][from][to] /= 2;
+								}
+							}
+						}
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	int bound = best >= beta ? BOUND_LOWER : (best > oldalpha ? BOUND_EXACT : BOUND_UPPER);
+	tt_store(s -> shared -> tt, pos -> key, depth, hash_pack(bestmove, score_tohash(best, ply), bound));
+	return best;
+}
+
+//deepen one ply at a time until a limit is hit, returns the best move of the last finished depth
+inline move_t search_run(searcher_t* s, searchlimits_t limits){
+	int maxdepth = limits.depth > 0 && limits.depth < MAX_PLY ? limits.depth : MAX_PLY - 1;
+	s -> nodelimit = limits.nodes;
+	int outcome;
+	s -> rootknown = bitbase_probe(&s -> pos, &outcome);
+
+	//stopped before the first depth finishes, any legal move is better than none
+	movelist_t list;
+	movegen_legal(&s -> pos, &list);
+	s -> bestmove = list.count ? list.moves[0] : MOVE_NONE;
+
+	//half the helper threads start a ply deeper so threads spread over different depths
+	for(int depth = 1 + (s -> id & 1); depth <= maxdepth; depth++){
+		int score = search_node(s, -SCORE_INF, SCORE_INF, depth, 0);
+		//a cut off iteration can't be trusted, keep the last finished one
+		if(s -> shared -> stop.load(std::memory_order_relaxed)){
+			break;
+		}
+		//a root with no legal moves leaves no line, and pv still holds the last search's
+		if(s -> pvlength[0] > 0){
+			s -> bestmove = s -> pv[0][0];
+			s -> pondermove = s -> pvlength[0] > 1 ? s -> pv[0][1] : MOVE_NONE;
+		}
+		s -> bestscore = score;
+		s -> depth = depth;
+		if(!s -> id && s -> shared -> report){
+			s -> shared -> report(s);
+		}
+		//no point looking deeper once a forced mate is found
+		if(score > SCORE_MATE - MAX_PLY || score < -SCORE_MATE + MAX_PLY){
+			break;
+		}
+	}
+	return s -> bestmove;
+}
+
+//search pos on threads searchers at once, searchers[0] on the calling thread. the helpers only
+//fill the shared table, once the main thread is done they are stopped and the deepest result wins.
+//ponder, if given, gets the reply the winning line expects
+inline move_t search_parallel(searcher_t* searchers, int threads, const position_t* pos, searchshared_t* shared, searchlimits_t limits, move_t* ponder){
+	std::thread helpers[MAX_THREADS];
+	if(threads > MAX_THREADS){
+		threads = MAX_THREADS;
+	}
+	if(threads < 1){
+		threads = 1;
+	}
+
+	shared -> nodes = 0;
+	shared -> start = search_clock();
+	//a pondering search leaves the deadline to whoever ends the ponder
+	if(!shared -> ponder){
+		shared -> deadline = limits.movetime > 0 ? search_clock() + (unsigned long)limits.movetime * 1000000 : 0;
+	}
+	for(int i = 0; i < threads; i++){
+		searcher_init(&searchers[i], pos, shared);
+		searchers[i].id = i;
+	}
+	for(int i = 1; i < threads; i++){
+		helpers[i] = std::thread(search_run, &searchers[i], limits);
+	}
+	search_run(&searchers[0], limits);
+	shared -> stop = 1;
+	for(int i = 1; i < threads; i++){
+		helpers[i].join();
+	}
+
+	searcher_t* best = &searchers[0];
+	for(int i = 1; i < threads; i++){
+		if(searchers[i].depth > best -> depth && searchers[i].bestmove != MOVE_NONE){
+			best = &searchers[i];
+		}
+	}
+	if(ponder){
+		*ponder = best -> pondermove;
+	}
+	return best -> bestmove;
+}
+
+//nodes searched by every thread of the last search_parallel
+inline uint64_t search_nodes(const searcher_t* searchers, int threads){
+	uint64_t nodes = 0;
+	for(int i = 0; i < threads; i++){
+		nodes += searchers[i].nodes;
+	}
+	return nodes;
+}
+
+#endif
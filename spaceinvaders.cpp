@@ -2,118 +2,71 @@
 #include <doge/window.h>
 #include <doge/graphics.h>
 #include <stdio.h>
+#include <string.h>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <math.h>
-#include <random>
-#include <time.h>
-
-unsigned long nanotime(){
-	timespec ts;
-
-	clock_gettime(CLOCK_MONOTONIC, &ts);
-
-	return ts.tv_sec * 1000000000 + ts.tv_nsec;
-}
-
-//get an image as an asset
-struct asset_s{
-	doge_image_t* image;
-	int width;
-	int height;
-};
-
-typedef struct asset_s asset_t;
-
-//make entity in game with asset
-struct entity_s{
-	asset_t* asset;
-	int x;
-	int y;
-	int width;
-	int height;
-};
-
-typedef struct entity_s entity_t;
-
-asset_t* asset_load(const char* filename){
-	doge_image_t* image;
-
-	image = doge_image_load(filename);
-	//if fail to load image, return null
-	if(!image){
-		printf("Failed loading img\n");
-		return nullptr;
-	}
-	asset_t* asset;
-	asset = (asset_t*)malloc(sizeof(asset_t));
-	//if failed to allocate memory, return nullptr
-	if(!asset){
-		doge_image_free(image);
-		printf("Failed to malloc\n");
-		return nullptr;
-	}
-	asset -> image = image;
-	asset -> width = doge_image_width(image);
-	asset -> height = doge_image_height(image);
-
-	return asset;
-}
-
-void asset_free(asset_t* asset){
-	doge_image_free(asset -> image);
-
-	free(asset);
-}
-
-//function to make entities
-entity_t* entity_create(asset_t* asset, int width, int height){
-	entity_t* entity = (entity_t*)malloc(sizeof(entity_t));
-	entity -> asset = asset;
-	entity -> width = width;
-	entity -> height = height;
-	entity -> x = 0;
-	entity -> y = 0;
-
-	return entity;
+#include <thread>
+#include <chrono>
+#include "sprite.h"
+#include "assets.h"
+#include "entities.h"
+#include "game.h"
+#include "replay.h"
+#include "nanotime.h"
+
+//usage: spaceinvaders            play
+//       spaceinvaders -r file    play and record the game to file
+//       spaceinvaders -p file    watch the game recorded in file, checking it plays out the same
+
+//where to draw something between ticks, blend 0 is where it was before the last tick and 1 is
+//where it is now
+float between(int previous, int current, float blend){
+	return previous + (current - previous) * blend;
 }
 
-void entity_free(entity_t* entity){
-	free(entity);
-	//entity is free, so free
-}
-//function to draw entity
-void entity_draw(entity_t* entity){
-	doge_draw_image(entity -> asset -> image, entity -> x, entity -> y, entity -> width, entity -> height);
+//function to queue entity in the frame's batch
+void entity_draw(spritebatch_t* batch, const assets_t* assets, entity_t* entity, float blend){
+	spritebatch_draw(batch, assets_sprite(assets, entity -> asset), between(entity -> previousx, entity -> x, blend),
+	                 between(entity -> previousy, entity -> y, blend), entity -> width, entity -> height);
 }
-//function to check if point is inside rectangle
-int point_in_rect(entity_t* rect, int x, int y){
-	if(x >= rect -> x && x <= rect -> x + rect -> width){
-		if(y >= rect -> y && y <= rect -> y + rect -> height){
-			return 1;
-		}
+//queue every entity in a store
+void entities_draw(spritebatch_t* batch, const assets_t* assets, const entities_t* entities, float blend){
+	for(int i = 0; i < entities -> count; i++){
+		spritebatch_draw(batch, assets_sprite(assets, entities -> asset[i]), between(entities -> previousx[i], entities -> x[i], blend),
+		                 between(entities -> previousy[i], entities -> y[i], blend), entities -> width[i], entities -> height[i]);
 	}
-	return 0;
 }
-//uses point_in_rect to check if any corner of rectangle is inside another rectangle
-int collides(entity_t* proj, entity_t* alien){
-	if(point_in_rect(alien, proj -> x, proj -> y)){
-		return 1;
+//keys held now, as game input
+int keys_held(doge_window_t* window){
+	int input = 0;
+	if(doge_window_keypressed(window, DOGE_KEY_W)){
+		input |= GAME_UP;
+	}
+	if(doge_window_keypressed(window, DOGE_KEY_A)){
+		input |= GAME_LEFT;
 	}
-	if(point_in_rect(alien, proj -> x + proj -> width, proj -> y)){
-		return 1;
+	if(doge_window_keypressed(window, DOGE_KEY_S)){
+		input |= GAME_DOWN;
 	}
-	if(point_in_rect(alien, proj -> x, proj -> y + proj -> height)){
-		return 1;
+	if(doge_window_keypressed(window, DOGE_KEY_D)){
+		input |= GAME_RIGHT;
 	}
-	if(point_in_rect(alien, proj -> x + proj -> width, proj -> y + proj -> height)){
-		return 1;
+	if(doge_window_keypressed(window, DOGE_KEY_SPACE)){
+		input |= GAME_FIRE;
 	}
-	return 0;
+	return input;
 }
 
-int main(){
-	srand(clock());
+int main(int argc, char** argv){
+	const char* recordfile = argc > 2 && !strcmp(argv[1], "-r") ? argv[2] : nullptr;
+	const char* replayfile = argc > 2 && !strcmp(argv[1], "-p") ? argv[2] : nullptr;
+
+	replay_t replay;
+
+	if(replayfile && !replay_open(&replay, replayfile)){
+		return -1;
+	}
 
 	int error;
 
@@ -137,6 +90,9 @@ int main(){
 
 	doge_window_makecurrentcontext(window);
 
+	//swapping waits for the monitor, so drawing doesn't run any faster than it can be shown
+	glfwSwapInterval(1);
+
 	error = glewInit();
 
 	if(error){
@@ -145,208 +101,150 @@ int main(){
 
 		return -1;
 	}
-	asset_t* spaceship_asset = asset_load("spaceship.png");
+	//every sprite comes from one atlas, stored at the size it's drawn
+	atlas_t atlas;
 
-	if(!spaceship_asset){
-		printf("Could not load asset\n");
+	if(!atlas_create(&atlas, 256, 128)){
 		return -1;
 	}
 
-	asset_t* projectile_asset = asset_load("projectile.png");
+	//images load in the background, the game runs from the first frame and each sprite shows up
+	//once it's in the atlas
+	assets_t assets;
 
-	if(!projectile_asset){
-		printf("Could not load asset\n");
+	if(!assets_create(&assets, &atlas, "assets.pak", 3, 3)){
 		return -1;
 	}
 
-	asset_t* alien_asset = asset_load("vqrus.png");
+	int spaceship_asset = assets_load(&assets, "spaceship.png", 100, 100);
+	int projectile_asset = assets_load(&assets, "projectile.png", 20, 100);
+	int alien_asset = assets_load(&assets, "vqrus.png", 100, 100);
+
+	//the window doesn't change size, the game is played on all of it. a replay is played on the
+	//size and seed it was recorded with
+	game_t game;
+	unsigned long seed = replayfile ? replay.seed : nanotime();
+	int width = replayfile ? replay.width : doge_window_width(window);
+	int height = replayfile ? replay.height : doge_window_height(window);
 
-	if(!alien_asset){
-		printf("Could not load asset\n");
+	if(!game_create(&game, width, height, seed, spaceship_asset, projectile_asset, alien_asset)){
 		return -1;
 	}
 
-	entity_t* spaceship;
-	spaceship = entity_create(spaceship_asset, 100, 100);
-
-	if(!spaceship){
-		printf("Failed to allocate memory for entity\n");
+	recorder_t recorder;
 
+	if(recordfile && !recorder_open(&recorder, recordfile, &game, seed)){
 		return -1;
 	}
 
+	//the whole frame is one draw call
+	spritebatch_t batch;
 
-	const int numProjectiles = 128;
-	entity_t* projectiles[numProjectiles];
-	//set all projectiles to null
-	for(int x = 0; x < numProjectiles; x++){
-		projectiles[x] = nullptr;
+	if(!spritebatch_create(&batch, &atlas, GAME_PROJECTILES + GAME_ALIENS + 1)){
+		return -1;
 	}
 
-	const int numAliens = 10;
+	const unsigned long tick_length = 1000000000 / GAME_TPS;
+	//most ticks run in one frame to catch up. after a longer stall the game falls behind instead of
+	//running ever more ticks to make up for the time those ticks take
+	const int max_catchup = 5;
 
-	entity_t* aliens[numAliens];
-	//set all aliens to null
-	for(int x = 0; x < numAliens; x++){
-		aliens[x] = nullptr;
-	}
+	//one frame per refresh. where the driver ignores the swap interval, whatever is left of the
+	//frame is slept off
+	const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+	const unsigned long frame_length = 1000000000 / (mode && mode -> refreshRate > 0 ? mode -> refreshRate : 60);
 
-	unsigned long last_tick = nanotime();
+	unsigned long last_time = nanotime();
 	unsigned long current_time;
+	//time passed that hasn't been ticked yet
+	unsigned long accumulator = 0;
 
-	const int tps = 60;
+	long spawned = 0;
 
-	int cooldown = 0;
+	//1 while the game goes on, 0 once it's over and -1 on failure
+	int playing = 1;
 
-	int aliencooldown = 0;
-
-	while(!doge_window_shouldclose(window)){
-		//shouldtick = nanosecondspassed * tickspersecond >= 1000000000
+	while(playing > 0 && !doge_window_shouldclose(window)){
+		assets_poll(&assets);
+		if(assets_state(&assets, spaceship_asset) == ASSET_FAILED || assets_state(&assets, projectile_asset) == ASSET_FAILED
+		  || assets_state(&assets, alien_asset) == ASSET_FAILED){
+			printf("Could not load asset\n");
+			return -1;
+		}
 
 		current_time = nanotime();
 
-		if((current_time - last_tick) * tps >= 1000000000){
-			last_tick = current_time;
+		accumulator += current_time - last_time;
+		last_time = current_time;
+		if(accumulator > max_catchup * tick_length){
+			accumulator = max_catchup * tick_length;
+		}
 
-			//move ship if WASD pressed
-			if(doge_window_keypressed(window, DOGE_KEY_W)){
-				spaceship -> y -= 10;
-			}
-			if(doge_window_keypressed(window, DOGE_KEY_A)){
-				spaceship -> x -= 10;
-			}
-			if(doge_window_keypressed(window, DOGE_KEY_S)){
-				spaceship -> y += 10;
-			}
-			if(doge_window_keypressed(window, DOGE_KEY_D)){
-				spaceship -> x += 10;
-			}
-			//Make sure ship cant go out of bounds
-			if(spaceship -> x + spaceship -> width > doge_window_width(window)){
-				spaceship -> x = doge_window_width(window) - spaceship -> width;
-			}
-			if(spaceship -> x < 0){
-				spaceship -> x = 0;
-			}
-			if(spaceship -> y + spaceship -> height > doge_window_height(window)){
-				spaceship -> y = doge_window_height(window) - spaceship -> height;
-			}
-			if(spaceship -> y < 0){
-				spaceship -> y = 0;
-			}
+		//as many ticks as fit in the time passed, each the same length whatever the frame rate
+		while(playing > 0 && accumulator >= tick_length){
+			accumulator -= tick_length;
 
-			if(cooldown)
-				cooldown--;
-
-			if(aliencooldown)
-				aliencooldown--;
-
-			//If space pressed, shoot projectile
-			if(doge_window_keypressed(window, DOGE_KEY_SPACE) && !cooldown){
-				for(int x = 0; x < numProjectiles; x++){
-					if(!projectiles[x]){
-						//make projectile after checking array for first null projectile
-						projectiles[x] = entity_create(projectile_asset, 20, 100);
-						//return -1 if making proj failed
-						if(!projectiles[x]){
-							return -1;
-						}
-						//make projectile at spaceship's x and y
-						projectiles[x] -> x = spaceship -> x + spaceship -> width /2 - projectiles[x] -> width / 2;
-						projectiles[x] -> y = spaceship -> y - projectiles[x] -> height;
-
-						cooldown = tps / 8;
-
-						break;
-					}
-				}
+			int input = replayfile ? replay_input(&replay, &game) : keys_held(window);
+			if(input == REPLAY_OVER){
+				printf("Replay over\n");
+				playing = 0;
+				break;
 			}
-			for(int x = 0; x < numProjectiles; x++){
-				if(projectiles[x]){
-					//move projectiles up
-					projectiles[x] -> y -= 35;
-					//free projectiles that are oob and set to null
-					if(projectiles[x] -> y < -projectiles[x] -> height){
-						entity_free(projectiles[x]);
-
-						projectiles[x] = nullptr;
-					}
-				}
+			if(input == REPLAY_DIVERGED){
+				playing = -1;
+				break;
 			}
-			if(!aliencooldown){
-				for(int i = 0; i < numAliens; i++){
-					if(!aliens[i]){
-						//make alien after finding null alien
-						aliens[i] = entity_create(alien_asset, 100, 100);
-						printf("Alien made\n");
-						//if alien creation fails, return -2
-						if(!aliens[i]){
-							printf("Alien failed\n");
-							return -2;
-						}
-						//give new alien random x coordinate
-						aliens[i] -> x = rand() % (doge_window_width(window) - aliens[i] -> width);
-						aliens[i] -> y = 0;
-
-						aliencooldown = 20;
-						break;
-					}
-				}
+			playing = game_tick(&game, input);
+			if(recordfile){
+				recorder_tick(&recorder, &game, input);
 			}
-			for(int i = 0; i < numAliens; i++){
-				//move aliens down
-				if(aliens[i]){
-					aliens[i] -> y += 5;
-					//if alien reaches bottom, game over
-					if(aliens[i] -> y > doge_window_height(window) - aliens[i] -> height){
-						printf("Game over\n");
-						return 0;
-					}
-				}
+			if(game.spawned != spawned){
+				spawned = game.spawned;
+				printf("Alien made\n");
 			}
-			for(int i = 0; i < numProjectiles; i++){
-				if(projectiles[i]){
-					for(int x = 0; x < numAliens; x++){
-						if(aliens[x]){
-							//if alien and proj collide, free both and set back to null
-							if(collides(projectiles[i], aliens[x])){
-								entity_free(aliens[x]);
-								entity_free(projectiles[i]);
-
-								aliens[x] = nullptr;
-								projectiles[i] = nullptr;
-								break;
-							}
-						}
-					}
+			if(!playing){
+				printf("Game over\n");
+				//the recording has to end here too
+				if(replayfile && replay_input(&replay, &game) != REPLAY_OVER){
+					playing = -1;
 				}
 			}
 		}
+		//how far this frame is into the next tick, everything is drawn that far from where it was
+		//toward where it is
+		float blend = (float)accumulator / tick_length;
+
 		/* clear the window */
 		doge_clear();
 
-		entity_draw(spaceship);
-
-		for(int i = 0; i < numProjectiles; i++){
-			if(projectiles[i]){
-				entity_draw(projectiles[i]);
-			}
-		}
-		for(int i = 0; i < numAliens; i++){
-			if(aliens[i]){
-				entity_draw(aliens[i]);
-			}
-		}
+		entity_draw(&batch, &assets, &game.spaceship, blend);
+		entities_draw(&batch, &assets, &game.projectiles, blend);
+		entities_draw(&batch, &assets, &game.aliens, blend);
+		spritebatch_flush(&batch);
 		/* swap the frame buffer */
 		doge_window_render(window);
 
 		/* check for keyboard, mouse, or close event */
 		doge_window_poll();
+
+		//with less than a quarter of the frame left the swap has already waited for the monitor,
+		//sleeping on would miss the next refresh
+		unsigned long spent = nanotime() - current_time;
+		if(spent < frame_length - frame_length / 4){
+			std::this_thread::sleep_for(std::chrono::nanoseconds(frame_length - spent));
+		}
 	}
 
-	asset_free(spaceship_asset);
-	asset_free(projectile_asset);
-	asset_free(alien_asset);
+	if(recordfile && !recorder_close(&recorder, &game)){
+		playing = -1;
+	}
+	if(replayfile){
+		replay_close(&replay);
+	}
+	game_free(&game);
+	assets_free(&assets);
+	spritebatch_free(&batch);
+	atlas_free(&atlas);
 
-	return 0;
+	return playing < 0 ? -1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,296 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include "image.h"
+
+//images packed into one texture (an atlas) and a batch that collects textured quads from it and
+//draws them all with one call, so a frame costs one texture bind however many sprites are on it
+//
+//images go straight into the texture as they're added, from wherever their pixels are, so a
+//memory mapped asset pack is uploaded without being copied first
+
+//where an image ended up in the atlas, in texture coordinates
+struct sprite_s{
+	float u0;
+	float v0;
+	float u1;
+	float v1;
+	int width;
+	int height;
+};
+
+typedef struct sprite_s sprite_t;
+
+struct atlas_s{
+	GLuint texture;
+	int width;
+	int height;
+	//images go in left to right along rows as tall as the tallest image in them
+	int x;
+	int y;
+	int row;
+	//plain white, tinted to fill rectangles without leaving the batch
+	sprite_t solid;
+};
+
+typedef struct atlas_s atlas_t;
+
+struct spritevertex_s{
+	float x;
+	float y;
+	float u;
+	float v;
+	unsigned char color[4];
+};
+
+typedef struct spritevertex_s spritevertex_t;
+
+struct spritebatch_s{
+	const atlas_t* atlas;
+	spritevertex_t* vertices;
+	int count;
+	int capacity;
+	//tint of the sprites added next
+	unsigned char color[4];
+};
+
+typedef struct spritebatch_s spritebatch_t;
+
+//empty space around every image, so filtering never picks up its neighbours
+const int ATLAS_PADDING = 1;
+
+//room in the atlas for a width by height image, returns 0 if it's full
+inline int atlas_place(atlas_t* atlas, int width, int height, int* x, int* y){
+	if(atlas -> x + width + ATLAS_PADDING > atlas -> width){
+		atlas -> x = ATLAS_PADDING;
+		atlas -> y += atlas -> row + ATLAS_PADDING;
+		atlas -> row = 0;
+	}
+	if(atlas -> x + width + ATLAS_PADDING > atlas -> width || atlas -> y + height + ATLAS_PADDING > atlas -> height){
+		return 0;
+	}
+	*x = atlas -> x;
+	*y = atlas -> y;
+	atlas -> x += width + ATLAS_PADDING;
+	if(height > atlas -> row){
+		atlas -> row = height;
+	}
+	return 1;
+}
+
+inline void atlas_sprite(const atlas_t* atlas, int x, int y, int width, int height, sprite_t* sprite){
+	sprite -> u0 = (float)x / atlas -> width;
+	sprite -> v0 = (float)y / atlas -> height;
+	sprite -> u1 = (float)(x + width) / atlas -> width;
+	sprite -> v1 = (float)(y + height) / atlas -> height;
+	sprite -> width = width;
+	sprite -> height = height;
+}
+
+//put width by height RGBA pixels, rows tightly packed, into the texture at x, y
+inline void atlas_upload(atlas_t* atlas, int x, int y, int width, int height, const unsigned char* pixels){
+	GLint texture;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	glBindTexture(GL_TEXTURE_2D, atlas -> texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+//start an empty width by height atlas, needs the GL context. returns 0 on failure
+inline int atlas_create(atlas_t* atlas, int width, int height){
+	atlas -> width = width;
+	atlas -> height = height;
+	atlas -> x = ATLAS_PADDING;
+	atlas -> y = ATLAS_PADDING;
+	atlas -> row = 0;
+	//the padding has to be see through, so the texture starts out cleared
+	unsigned char* clear = (unsigned char*)calloc((size_t)width * height, 4);
+	if(!clear){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	GLint texture;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	glGenTextures(1, &atlas -> texture);
+	glBindTexture(GL_TEXTURE_2D, atlas -> texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, clear);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	free(clear);
+
+	//sampled at the middle, so filtering only ever sees white
+	unsigned char white[4 * 4 * 4];
+	memset(white, 0xFF, sizeof(white));
+	int x;
+	int y;
+	atlas_place(atlas, 4, 4, &x, &y);
+	atlas_upload(atlas, x, y, 4, 4, white);
+	atlas_sprite(atlas, x + 2, y + 2, 0, 0, &atlas -> solid);
+	return 1;
+}
+
+//put image in the atlas at width by height, scaling it if that isn't its own size. returns 0 if
+//there's no room left
+inline int atlas_add(atlas_t* atlas, const image_t* image, int width, int height, sprite_t* sprite){
+	int x;
+	int y;
+	if(!atlas_place(atlas, width, height, &x, &y)){
+		printf("Failed to fit image in atlas\n");
+		return 0;
+	}
+	if(width == image -> width && height == image -> height){
+		atlas_upload(atlas, x, y, width, height, image -> pixels);
+	} else{
+		unsigned char* scaled = (unsigned char*)malloc((size_t)width * height * 4);
+		if(!scaled){
+			printf("Failed to allocate memory\n");
+			return 0;
+		}
+		image_resample(image, scaled, width * 4, width, height);
+		atlas_upload(atlas, x, y, width, height, scaled);
+		free(scaled);
+	}
+	atlas_sprite(atlas, x, y, width, height, sprite);
+	return 1;
+}
+
+inline void atlas_free(atlas_t* atlas){
+	glDeleteTextures(1, &atlas -> texture);
+	atlas -> texture = 0;
+}
+
+//batch for sprites from atlas, room for capacity sprites before it has to grow. returns 0 on failure
+inline int spritebatch_create(spritebatch_t* batch, const atlas_t* atlas, int capacity){
+	batch -> atlas = atlas;
+	batch -> count = 0;
+	batch -> capacity = capacity;
+	batch -> vertices = (spritevertex_t*)malloc((size_t)capacity * 4 * sizeof(spritevertex_t));
+	if(!batch -> vertices){
+		printf("Failed to allocate memory\n");
+		return 0;
+	}
+	memset(batch -> color, 0xFF, 4);
+	return 1;
+}
+
+inline void spritebatch_free(spritebatch_t* batch){
+	free(batch -> vertices);
+	batch -> vertices = nullptr;
+	batch -> count = 0;
+	batch -> capacity = 0;
+}
+
+inline void spritebatch_setcolor_alpha(spritebatch_t* batch, float r, float g, float b, float a){
+	batch -> color[0] = (unsigned char)(r * 255 + 0.5f);
+	batch -> color[1] = (unsigned char)(g * 255 + 0.5f);
+	batch -> color[2] = (unsigned char)(b * 255 + 0.5f);
+	batch -> color[3] = (unsigned char)(a * 255 + 0.5f);
+}
+
+inline void spritebatch_setcolor(spritebatch_t* batch, float r, float g, float b){
+	spritebatch_setcolor_alpha(batch, r, g, b, 1);
+}
+
+inline void spritebatch_vertex(spritevertex_t* vertex, const spritebatch_t* batch, float x, float y, float u, float v){
+	vertex -> x = x;
+	vertex -> y = y;
+	vertex -> u = u;
+	vertex -> v = v;
+	memcpy(vertex -> color, batch -> color, 4);
+}
+
+//queue sprite stretched over the width by height rectangle with its top left corner at x, y. a
+//nullptr sprite, one still loading, draws nothing
+inline void spritebatch_draw(spritebatch_t* batch, const sprite_t* sprite, float x, float y, float width, float height){
+	if(!sprite){
+		return;
+	}
+	if(batch -> count == batch -> capacity){
+		int capacity = batch -> capacity ? batch -> capacity * 2 : 64;
+		spritevertex_t* vertices = (spritevertex_t*)realloc(batch -> vertices, (size_t)capacity * 4 * sizeof(spritevertex_t));
+		if(!vertices){
+			printf("Failed to allocate memory\n");
+			return;
+		}
+		batch -> vertices = vertices;
+		batch -> capacity = capacity;
+	}
+	spritevertex_t* quad = batch -> vertices + batch -> count * 4;
+	spritebatch_vertex(quad + 0, batch, x, y, sprite -> u0, sprite -> v0);
+	spritebatch_vertex(quad + 1, batch, x + width, y, sprite -> u1, sprite -> v0);
+	spritebatch_vertex(quad + 2, batch, x + width, y + height, sprite -> u1, sprite -> v1);
+	spritebatch_vertex(quad + 3, batch, x, y + height, sprite -> u0, sprite -> v1);
+	batch -> count++;
+}
+
+//queue a rectangle of the current color
+inline void spritebatch_fill(spritebatch_t* batch, float x, float y, float width, float height){
+	spritebatch_draw(batch, &batch -> atlas -> solid, x, y, width, height);
+}
+
+//draw everything queued in one call, in the order it was queued, and empty the batch. coordinates
+//are pixels of the current viewport from its top left, and the caller's GL state is left as it was
+inline void spritebatch_flush(spritebatch_t* batch){
+	if(!batch -> count){
+		return;
+	}
+	GLint program;
+	GLint texture;
+	GLint buffer;
+	GLint array;
+	GLint viewport[4];
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &buffer);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &array);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	//the vertices come straight from memory
+	glUseProgram(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, batch -> atlas -> texture);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, viewport[2], viewport[3], 0, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(spritevertex_t), &batch -> vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(spritevertex_t), &batch -> vertices[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(spritevertex_t), batch -> vertices[0].color);
+	glDrawArrays(GL_QUADS, 0, batch -> count * 4);
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopClientAttrib();
+	glPopAttrib();
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBindVertexArray(array);
+	glUseProgram(program);
+	batch -> count = 0;
+}
+
+#endif
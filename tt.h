@@ -0,0 +1,140 @@
+#ifndef TT_H
+#define TT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+
+//transposition table, a fixed size hash of positions by zobrist key shared by every thread
+//
+//each entry is two words, the data and the key xored with the data, written without locks.
+//a reader that catches another thread halfway through a write sees a key that doesn't
+//match and treats the entry as missing, so torn entries are never used
+//
+//the low 16 bits of the data belong to the table (depth and age, used to pick what to
+//replace), callers store anything they like in the other 48
+
+struct ttentry_s{
+	std::atomic<uint64_t> check;
+	std::atomic<uint64_t> data;
+};
+
+typedef struct ttentry_s ttentry_t;
+
+//four entries fill one 64 byte cache line, a probe touches a single line
+const int TT_BUCKET = 4;
+
+struct alignas(64) ttbucket_s{
+	ttentry_t entries[TT_BUCKET];
+};
+
+typedef struct ttbucket_s ttbucket_t;
+
+struct tt_s{
+	ttbucket_t* buckets;
+	uint64_t count;
+	//bumped once per search so entries from old searches get replaced first
+	unsigned char generation;
+};
+
+typedef struct tt_s tt_t;
+
+//reserve size_mb megabytes, rounded down to a whole number of buckets, returns 0 on failure
+inline int tt_create(tt_t* tt, int size_mb){
+	uint64_t count = (uint64_t)size_mb * 1024 * 1024 / sizeof(ttbucket_t);
+	if(count < 1){
+		count = 1;
+	}
+	tt -> buckets = (ttbucket_t*)aligned_alloc(64, count * sizeof(ttbucket_t));
+	if(!tt -> buckets){
+		printf("Failed to allocate memory\n");
+		tt -> count = 0;
+		return 0;
+	}
+	tt -> count = count;
+	tt -> generation = 0;
+	for(uint64_t i = 0; i < count; i++){
+		for(int j = 0; j < TT_BUCKET; j++){
+			tt -> buckets[i].entries[j].check.store(0, std::memory_order_relaxed);
+			tt -> buckets[i].entries[j].data.store(0, std::memory_order_relaxed);
+		}
+	}
+	return 1;
+}
+
+inline void tt_free(tt_t* tt){
+	free(tt -> buckets);
+	tt -> buckets = nullptr;
+	tt -> count = 0;
+}
+
+inline void tt_clear(tt_t* tt){
+	for(uint64_t i = 0; i < tt -> count; i++){
+		for(int j = 0; j < TT_BUCKET; j++){
+			tt -> buckets[i].entries[j].check.store(0, std::memory_order_relaxed);
+			tt -> buckets[i].entries[j].data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+inline void tt_newsearch(tt_t* tt){
+	tt -> generation++;
+}
+
+//map a key onto a bucket with a multiply instead of a modulo, any bucket count works
+inline ttbucket_t* tt_bucket(const tt_t* tt, uint64_t key){
+	return &tt -> buckets[(uint64_t)(((unsigned __int128)key * tt -> count) >> 64)];
+}
+
+//start fetching the bucket for key, for callers that know they'll probe it soon
+inline void tt_prefetch(const tt_t* tt, uint64_t key){
+	__builtin_prefetch(tt_bucket(tt, key));
+}
+
+//find key, filling in the caller's 48 bits and the depth it was stored with
+inline int tt_probe(const tt_t* tt, uint64_t key, uint64_t* payload, int* depth){
+	ttbucket_t* bucket = tt_bucket(tt, key);
+	for(int i = 0; i < TT_BUCKET; i++){
+		uint64_t data = bucket -> entries[i].data.load(std::memory_order_relaxed);
+		uint64_t check = bucket -> entries[i].check.load(std::memory_order_relaxed);
+		if((check ^ data) == key && data){
+			*payload = data >> 16;
+			*depth = data & 0xFF;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+//store payload for key, overwriting the same key if present, else the shallowest or oldest entry
+inline void tt_store(tt_t* tt, uint64_t key, int depth, uint64_t payload){
+	ttbucket_t* bucket = tt_bucket(tt, key);
+	ttentry_t* replace = &bucket -> entries[0];
+	int worst = 1 << 30;
+	for(int i = 0; i < TT_BUCKET; i++){
+		ttentry_t* entry = &bucket -> entries[i];
+		uint64_t data = entry -> data.load(std::memory_order_relaxed);
+		if((entry -> check.load(std::memory_order_relaxed) ^ data) == key){
+			replace = entry;
+			break;
+		}
+		int age = (unsigned char)(tt -> generation - (data >> 8));
+		int value = (int)(data & 0xFF) - 8 * age;
+		if(value < worst){
+			worst = value;
+			replace = entry;
+		}
+	}
+	if(depth < 0){
+		depth = 0;
+	}
+	if(depth > 255){
+		depth = 255;
+	}
+	uint64_t data = (payload << 16) | ((uint64_t)tt -> generation << 8) | (uint64_t)depth;
+	replace -> data.store(data, std::memory_order_relaxed);
+	replace -> check.store(key ^ data, std::memory_order_relaxed);
+}
+
+#endif
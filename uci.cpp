@@ -0,0 +1,8 @@
+#include "uci.h"
+
+//headless engine speaking UCI, needs no window, display or graphics libraries
+//usage: uci
+
+int main(){
+	return uci_loop();
+}
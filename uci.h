@@ -0,0 +1,376 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "bitboard.h"
+#include "tt.h"
+#include "search.h"
+#include "engine.h"
+#include "book.h"
+
+//universal chess interface on stdin and stdout, for running the engine under a tournament
+//manager or any other GUI without opening a window
+//
+//commands are read on the calling thread while the engine searches on its worker, a second
+//thread waits on the mailbox and prints bestmove so stop, isready and ponderhit are answered
+//straight away even mid search. both threads sleep on a condition variable while they wait,
+//woken by the engine when a job ends and by each other as the job changes
+
+const int UCI_HASH_DEFAULT = 64;
+const int UCI_HASH_MAX = 65536;
+const int UCI_LINE = 1 << 16;
+
+struct uci_s{
+	engine_t engine;
+	int hash_mb;
+	int threads;
+	//opening book from the BookFile option, empty when there's none
+	book_t book;
+	//the Ponder option, bestmove only names a reply to ponder on while it's set
+	std::atomic<int> ponder;
+	position_t pos;
+	//job the printer is waiting on, 0 when none
+	std::atomic<uint32_t> job;
+	std::atomic<int> quit;
+	//waits on wake, the lock is only taken to sleep and to wake
+	std::mutex lock;
+	std::condition_variable wake;
+};
+
+typedef struct uci_s uci_t;
+
+//the long algebraic notation UCI uses is move_tostring, so a move is found by matching it
+inline move_t uci_parsemove(const position_t* pos, const char* text){
+	movelist_t list;
+	char name[6];
+	movegen_legal(pos, &list);
+	for(int i = 0; i < list.count; i++){
+		move_tostring(list.moves[i], name);
+		if(!strcmp(name, text)){
+			return list.moves[i];
+		}
+	}
+	return MOVE_NONE;
+}
+
+inline void uci_report(const searcher_t* s){
+	unsigned long elapsed = (search_clock() - s -> shared -> start) / 1000000;
+	//the shared count is added to in batches, the main thread's unsent ones are counted here
+	uint64_t nodes = s -> shared -> nodes.load(std::memory_order_relaxed) + (s -> nodes & 1023);
+	char score[32];
+	if(s -> bestscore > SCORE_MATE - MAX_PLY){
+		snprintf(score, sizeof(score), "mate %d", (SCORE_MATE - s -> bestscore + 1) / 2);
+	} else
+	if(s -> bestscore < -SCORE_MATE + MAX_PLY){
+		//a root that is already mated is mate 0, not mate -0
+		snprintf(score, sizeof(score), "mate %d", -((SCORE_MATE + s -> bestscore) / 2));
+	} else{
+		snprintf(score, sizeof(score), "cp %d", s -> bestscore);
+	}
+	//one printf for the whole line so it can't interleave with the other thread's output
+	char line[16 * MAX_PLY];
+	int length = snprintf(line, sizeof(line), "info depth %d score %s nodes %llu nps %llu time %lu pv",
+		s -> depth, score, (unsigned long long)nodes, (unsigned long long)(elapsed ? nodes * 1000 / elapsed : nodes), elapsed);
+	for(int i = 0; i < s -> pvlength[0] && length < (int)sizeof(line) - 8; i++){
+		char name[6];
+		move_tostring(s -> pv[0][i], name);
+		length += snprintf(line + length, sizeof(line) - length, " %s", name);
+	}
+	printf("%s\n", line);
+	fflush(stdout);
+}
+
+//wake whoever waits after changing what they wait on, as engine_wake does
+inline void uci_wake(void* user){
+	uci_t* uci = (uci_t*)user;
+	{
+		std::lock_guard<std::mutex> guard(uci -> lock);
+	}
+	uci -> wake.notify_all();
+}
+
+//whether the answer to the job the printer is waiting on has arrived
+inline int uci_answered(uci_t* uci){
+	uint32_t job = uci -> job.load(std::memory_order_acquire);
+	return job && (uint32_t)(uci -> engine.mailbox.load(std::memory_order_acquire) >> 32) == job;
+}
+
+//prints bestmove for each job as its answer arrives
+inline void uci_printer(uci_t* uci){
+	while(!uci -> quit.load(std::memory_order_acquire)){
+		uint32_t job = uci -> job.load(std::memory_order_acquire);
+		move_t move, ponder;
+		if(job && engine_takemove(&uci -> engine, job, &move, &ponder)){
+			uci -> job.store(0, std::memory_order_release);
+			char name[6], pondername[6];
+			move_tostring(move, name);
+			move_tostring(ponder, pondername);
+			if(move == MOVE_NONE){
+				printf("bestmove 0000\n");
+			} else
+			if(ponder != MOVE_NONE && uci -> ponder.load(std::memory_order_relaxed)){
+				printf("bestmove %s ponder %s\n", name, pondername);
+			} else{
+				printf("bestmove %s\n", name);
+			}
+			fflush(stdout);
+			uci_wake(uci);
+			continue;
+		}
+		std::unique_lock<std::mutex> guard(uci -> lock);
+		uci -> wake.wait(guard, [uci]{
+			return uci -> quit.load(std::memory_order_acquire) || uci_answered(uci);
+		});
+	}
+}
+
+//end the running search, its answer is still printed, and wait for the worker to go idle
+inline void uci_stop(uci_t* uci){
+	engine_finish(&uci -> engine);
+	std::unique_lock<std::mutex> guard(uci -> lock);
+	uci -> wake.wait(guard, [uci]{
+		return engine_idle(&uci -> engine) && !uci -> job.load(std::memory_order_acquire);
+	});
+}
+
+//engine with the current options, dropping the old one, returns 0 on failure
+inline int uci_restart(uci_t* uci){
+	uci_stop(uci);
+	engine_free(&uci -> engine);
+	if(!engine_create(&uci -> engine, uci -> threads, uci -> hash_mb)){
+		return 0;
+	}
+	uci -> engine.shared.report = uci_report;
+	uci -> engine.done = uci_wake;
+	uci -> engine.user = uci;
+	uci -> engine.book = uci -> book.count ? &uci -> book : nullptr;
+	return 1;
+}
+
+//position [startpos | fen <fen>] [moves <move>...]
+inline void uci_position(uci_t* uci, char* args){
+	char* moves = strstr(args, " moves");
+	if(moves){
+		*moves = '\0';
+		moves += 6;
+	}
+	while(*args == ' '){
+		args++;
+	}
+	if(!strncmp(args, "fen", 3)){
+		if(!position_fromfen(&uci -> pos, args + 3 + strspn(args + 3, " "))){
+			printf("info string bad fen\n");
+			position_start(&uci -> pos);
+			return;
+		}
+	} else{
+		position_start(&uci -> pos);
+	}
+	if(!moves){
+		return;
+	}
+	for(char* name = strtok(moves, " \t\r\n"); name; name = strtok(nullptr, " \t\r\n")){
+		move_t move = uci_parsemove(&uci -> pos, name);
+		if(move == MOVE_NONE){
+			printf("info string illegal move %s\n", name);
+			return;
+		}
+		//keep room for the search and enough moves back for repetitions
+		if(uci -> pos.ply >= MAX_HISTORY - MAX_PLY){
+			position_trimhistory(&uci -> pos, 128);
+		}
+		position_makemove(&uci -> pos, move);
+	}
+}
+
+//go [depth n] [movetime ms] [nodes n] [wtime ms btime ms winc ms binc ms movestogo n] [infinite] [ponder]
+inline void uci_go(uci_t* uci, char* args){
+	searchlimits_t limits = {0, 0, 0, 0};
+	long time[2] = {-1, -1};
+	long increment[2] = {0, 0};
+	int movestogo = 0;
+	int ponder = 0;
+	int infinite = 0;
+
+	char* word = strtok(args, " \t\r\n");
+	while(word){
+		char* value = strtok(nullptr, " \t\r\n");
+		long number = value ? atol(value) : 0;
+		int used = 1;
+		if(!strcmp(word, "depth")) limits.depth = number;
+		else if(!strcmp(word, "movetime")) limits.movetime = number;
+		else if(!strcmp(word, "nodes")) limits.nodes = number;
+		else if(!strcmp(word, "wtime")) time[WHITE] = number;
+		else if(!strcmp(word, "btime")) time[BLACK] = number;
+		else if(!strcmp(word, "winc")) increment[WHITE] = number;
+		else if(!strcmp(word, "binc")) increment[BLACK] = number;
+		else if(!strcmp(word, "movestogo")) movestogo = number;
+		else{
+			//flags without a value
+			used = 0;
+			if(!strcmp(word, "infinite")) infinite = 1;
+			if(!strcmp(word, "ponder")) ponder = 1;
+		}
+		word = used ? strtok(nullptr, " \t\r\n") : value;
+	}
+
+	//a clock shares what's left out over the moves still to come, keeping a little back
+	int us = uci -> pos.turn;
+	if(!limits.movetime && !infinite && time[us] >= 0){
+		long share = time[us] / (movestogo > 0 ? movestogo : 30) + increment[us] * 3 / 4;
+		long spare = time[us] - 50;
+		limits.movetime = share < spare ? share : spare;
+		if(limits.movetime < 1){
+			limits.movetime = 1;
+		}
+	}
+
+	limits.infinite = infinite;
+
+	uci_stop(uci);
+	uint32_t job = engine_go(&uci -> engine, &uci -> pos, limits, ponder);
+	uci -> job.store(job, std::memory_order_release);
+	uci_wake(uci);
+}
+
+inline void uci_setoption(uci_t* uci, char* args){
+	char* name = strstr(args, "name ");
+	char* value = strstr(args, " value ");
+	if(!name || !value){
+		return;
+	}
+	*value = '\0';
+	name += 5;
+	value += 7;
+	if(!strcasecmp(name, "Hash")){
+		uci -> hash_mb = atoi(value);
+		if(uci -> hash_mb < 1){
+			uci -> hash_mb = 1;
+		}
+		if(uci -> hash_mb > UCI_HASH_MAX){
+			uci -> hash_mb = UCI_HASH_MAX;
+		}
+		if(!uci_restart(uci)){
+			uci -> hash_mb = UCI_HASH_DEFAULT;
+			uci_restart(uci);
+		}
+	} else
+	if(!strcasecmp(name, "Threads")){
+		uci -> threads = atoi(value);
+		if(uci -> threads < 1){
+			uci -> threads = 1;
+		}
+		if(uci -> threads > MAX_THREADS){
+			uci -> threads = MAX_THREADS;
+		}
+		uci_restart(uci);
+	} else
+	if(!strcasecmp(name, "BookFile")){
+		uci_stop(uci);
+		book_close(&uci -> book);
+		if(*value && strcmp(value, "<empty>") && !book_open(&uci -> book, value)){
+			printf("info string no book at %s\n", value);
+		}
+		uci -> engine.book = uci -> book.count ? &uci -> book : nullptr;
+	} else
+	if(!strcasecmp(name, "Ponder")){
+		uci -> ponder.store(!strcasecmp(value, "true"), std::memory_order_relaxed);
+	}
+}
+
+//talk UCI on stdin and stdout until quit or end of input, never touching graphics
+inline int uci_loop(){
+	static uci_t uci;
+	static char line[UCI_LINE];
+
+	attacks_init();
+	//endgame bitbases are optional, bitbasegen writes them
+	if(bitbase_load("bitbases.bin")){
+		printf("info string bitbases loaded\n");
+	}
+	uci.hash_mb = UCI_HASH_DEFAULT;
+	uci.threads = 1;
+	uci.ponder = 1;
+	uci.job = 0;
+	uci.quit = 0;
+	position_start(&uci.pos);
+	if(!engine_create(&uci.engine, uci.threads, uci.hash_mb)){
+		return -1;
+	}
+	uci.engine.shared.report = uci_report;
+	uci.engine.done = uci_wake;
+	uci.engine.user = &uci;
+	std::thread printer(uci_printer, &uci);
+
+	int quit = 0;
+	while(!quit && fgets(line, sizeof(line), stdin)){
+		line[strcspn(line, "\r\n")] = '\0';
+		char* args = line + strcspn(line, " ");
+		if(*args){
+			*args++ = '\0';
+		}
+		if(!strcmp(line, "uci")){
+			printf("id name Said chess\nid author saidongithub\n");
+			printf("option name Hash type spin default %d min 1 max %d\n", UCI_HASH_DEFAULT, UCI_HASH_MAX);
+			printf("option name Threads type spin default 1 min 1 max %d\n", MAX_THREADS);
+			printf("option name Ponder type check default true\n");
+			printf("option name BookFile type string default <empty>\n");
+			printf("uciok\n");
+		} else
+		if(!strcmp(line, "isready")){
+			printf("readyok\n");
+		} else
+		if(!strcmp(line, "ucinewgame")){
+			uci_stop(&uci);
+			tt_clear(&uci.engine.hash);
+			position_start(&uci.pos);
+		} else
+		if(!strcmp(line, "position")){
+			uci_stop(&uci);
+			uci_position(&uci, args);
+		} else
+		if(!strcmp(line, "go")){
+			uci_go(&uci, args);
+		} else
+		if(!strcmp(line, "stop")){
+			engine_finish(&uci.engine);
+		} else
+		if(!strcmp(line, "ponderhit")){
+			engine_ponderhit(&uci.engine);
+		} else
+		if(!strcmp(line, "setoption")){
+			uci_setoption(&uci, args);
+		} else
+		if(!strcmp(line, "quit")){
+			quit = 1;
+		} else
+		if(*line){
+			printf("info string unknown command %s\n", line);
+		}
+		fflush(stdout);
+	}
+
+	//input that just ends lets a timed search finish, quit or an open ended one is cut short
+	if(!quit){
+		std::unique_lock<std::mutex> guard(uci.lock);
+		uci.wake.wait(guard, []{
+			return !uci.job.load(std::memory_order_acquire) || uci.engine.shared.ponder.load(std::memory_order_acquire) || uci.engine.limits.infinite;
+		});
+	}
+	uci_stop(&uci);
+	uci.quit = 1;
+	uci_wake(&uci);
+	printer.join();
+	engine_free(&uci.engine);
+	book_close(&uci.book);
+	return 0;
+}
+
+#endif